@@ -0,0 +1,604 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
+#include "bounded_buffer.h"
+
+#define YIELD_AFTER 64
+
+/*
+ * 유한버퍼를 type 방식과 size 크기로 초기화한다.
+ * 성공하면 BBUF_SUCCESS를, 실패하면 BBUF_FAIL을 리턴한다.
+ */
+int bbuf_init(bbuf_t *q, int type, int size)
+{
+    if (type < BBUF_CAS || type > BBUF_FAST || size <= 0)
+        return BBUF_FAIL;
+    q->buffer = (int *)malloc(sizeof(int)*size);
+    if (q->buffer == NULL)
+        return BBUF_FAIL;
+    q->type = type;
+    q->size = size;
+    q->in = q->out = q->counter = 0;
+    atomic_init(&q->nput, 0);
+    atomic_init(&q->nget, 0);
+    atomic_init(&q->pwaiting, 0);
+    atomic_init(&q->cwaiting, 0);
+    atomic_init(&q->closed, 0);
+    atomic_init(&q->pactive, 0);
+    q->threads = NULL;
+    memset(q->retired, 0, sizeof(q->retired));
+    if (spinlock_init(&q->reglock, SPIN_TTAS) != SPIN_SUCCESS)
+        goto fail;
+    switch (type) {
+        case BBUF_CAS:
+            if (spinlock_init(&q->lock, SPIN_TTAS) != SPIN_SUCCESS)
+                goto fail;
+            break;
+        case BBUF_SPIN:
+            if (spinlock_init(&q->lock, SPIN_MCS) != SPIN_SUCCESS)
+                goto fail;
+            break;
+        case BBUF_SEM:
+            sem_init(&q->empty, 0, size);
+            sem_init(&q->full, 0, 0);
+            sem_init(&q->pro_mutex, 0, 1);
+            sem_init(&q->con_mutex, 0, 1);
+            break;
+        case BBUF_FAST:
+            fsem_init(&q->fempty, size);
+            fsem_init(&q->ffull, 0);
+            atomic_init(&q->in_claim, 0);
+            atomic_init(&q->in_commit, 0);
+            atomic_init(&q->out_claim, 0);
+            atomic_init(&q->out_commit, 0);
+            break;
+    }
+    return BBUF_SUCCESS;
+fail:
+    free(q->buffer);
+    q->buffer = NULL;
+    return BBUF_FAIL;
+}
+
+/*
+ * 유한버퍼에 할당된 자원을 모두 반납한다. 버퍼를 사용하는 스레드가 없어야 한다.
+ */
+void bbuf_destroy(bbuf_t *q)
+{
+    if (q->type == BBUF_SEM) {
+        sem_destroy(&q->empty);
+        sem_destroy(&q->full);
+        sem_destroy(&q->pro_mutex);
+        sem_destroy(&q->con_mutex);
+    }
+    else if (q->type != BBUF_FAST)
+        spinlock_destroy(&q->lock);
+    spinlock_destroy(&q->reglock);
+    free(q->buffer);
+    q->buffer = NULL;
+}
+
+/*
+ * 스레드가 유한버퍼 q를 사용하기 전에 자신의 정보를 준비하고, 통계를 모을 수 있도록 q에 등록한다.
+ */
+int bbuf_thread_init(bbuf_t *q, bbuf_thread_t *self)
+{
+    if (spin_node_init(&self->node) != SPIN_SUCCESS)
+        return BBUF_FAIL;
+    for (int k = 0; k < BBUF_NSTAT; ++k)
+        atomic_init(&self->stat[k], 0);
+    spin_lock(&q->reglock, NULL);
+    self->next = q->threads;
+    q->threads = self;
+    spin_unlock(&q->reglock, NULL);
+    return BBUF_SUCCESS;
+}
+
+/*
+ * 스레드의 등록을 해제한다. 이 스레드의 통계는 q의 retired에 더해지므로 bbuf_stats()에 계속 나타난다.
+ */
+void bbuf_thread_destroy(bbuf_t *q, bbuf_thread_t *self)
+{
+    bbuf_thread_t **p;
+
+    spin_lock(&q->reglock, NULL);
+    for (p = &q->threads; *p != NULL; p = &(*p)->next)
+        if (*p == self) {
+            *p = self->next;
+            break;
+        }
+    for (int k = 0; k < BBUF_NSTAT; ++k)
+        q->retired[k] += atomic_load_explicit(&self->stat[k], memory_order_relaxed);
+    spin_unlock(&q->reglock, NULL);
+    spin_node_destroy(&self->node);
+}
+
+/*
+ * 스레드 self의 통계를 stat[BBUF_NSTAT]에 복사한다. 다른 스레드가 실행 중에 불러도 된다.
+ */
+void bbuf_thread_stats(bbuf_thread_t *self, long *stat)
+{
+    for (int k = 0; k < BBUF_NSTAT; ++k)
+        stat[k] = atomic_load_explicit(&self->stat[k], memory_order_relaxed);
+}
+
+/*
+ * 유한버퍼 q를 사용했거나 사용 중인 모든 스레드의 통계를 합해서 stat[BBUF_NSTAT]에 저장한다.
+ * 실행 중에 부르면 스레드마다 조금씩 다른 시점의 값이 합해진다.
+ */
+void bbuf_stats(bbuf_t *q, long *stat)
+{
+    spin_lock(&q->reglock, NULL);
+    for (int k = 0; k < BBUF_NSTAT; ++k)
+        stat[k] = q->retired[k];
+    for (bbuf_thread_t *t = q->threads; t != NULL; t = t->next)
+        for (int k = 0; k < BBUF_NSTAT; ++k)
+            stat[k] += atomic_load_explicit(&t->stat[k], memory_order_relaxed);
+    spin_unlock(&q->reglock, NULL);
+}
+
+/*
+ * 스레드 자신의 통계 k에 v를 더한다. 이 스레드만 고치므로 읽기-수정-쓰기 연산이 필요 없다.
+ */
+static void stat_add(bbuf_thread_t *self, int k, long v)
+{
+    if (v != 0)
+        atomic_store_explicit(&self->stat[k],
+                              atomic_load_explicit(&self->stat[k], memory_order_relaxed) + v,
+                              memory_order_relaxed);
+}
+
+static long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/*
+ * 스핀락 노드에 쌓인 돈 횟수와 실패한 CAS 횟수를 스레드의 통계로 옮긴다.
+ */
+static void account_lock(bbuf_thread_t *self)
+{
+    stat_add(self, BBUF_STAT_SPIN, (long)self->node.spins);
+    stat_add(self, BBUF_STAT_FAIL, (long)self->node.fails);
+    self->node.spins = self->node.fails = 0;
+}
+
+/*
+ * 원형 버퍼의 pos 위치부터 items의 아이템 n개를 복사한다. 끝을 넘어가면 두 조각으로 나눠서 복사한다.
+ */
+static void copy_in(bbuf_t *q, int pos, const int *items, int n)
+{
+    int first = q->size - pos < n ? q->size - pos : n;
+
+    memcpy(q->buffer + pos, items, sizeof(int)*first);
+    memcpy(q->buffer, items + first, sizeof(int)*(n - first));
+}
+
+/*
+ * 원형 버퍼의 pos 위치부터 아이템 n개를 items로 복사한다.
+ */
+static void copy_out(bbuf_t *q, int pos, int *items, int n)
+{
+    int first = q->size - pos < n ? q->size - pos : n;
+
+    memcpy(items, q->buffer + pos, sizeof(int)*first);
+    memcpy(items + first, q->buffer, sizeof(int)*(n - first));
+}
+
+/*
+ * 스핀락으로 보호하는 방식에서 아이템을 최대 n개 넣고, 넣은 개수를 리턴한다.
+ * 버퍼가 가득 차 있으면 락을 풀고, BBUF_CAS는 nget이 바뀔 때까지 잠들고
+ * BBUF_SPIN은 잠시 쉬었다가 다시 시도한다. 빈 자리가 생기면 들어가는 만큼 한 번에 넣는다.
+ * 버퍼가 닫혔으면 넣지 않고 -1을 리턴한다. closed는 seen을 읽은 다음에 검사해야
+ * bbuf_close()가 seq를 바꿔서 깨우는 것을 놓치지 않는다.
+ */
+static int spin_put(bbuf_t *q, bbuf_thread_t *self, const int *items, int n)
+{
+    int seen, m;
+    long t0;
+
+    while (true) {
+        spin_lock(&q->lock, &self->node);
+        account_lock(self);
+        seen = atomic_load_explicit(&q->nget, memory_order_relaxed);
+        if (atomic_load(&q->closed)) {
+            spin_unlock(&q->lock, &self->node);
+            return -1;
+        }
+        if (q->counter < q->size)
+            break;
+        spin_unlock(&q->lock, &self->node);
+        t0 = now_ns();
+        if (q->type == BBUF_CAS)
+            stat_add(self, BBUF_STAT_SPIN, futex_park(&q->nget, seen, &q->pwaiting));
+        else
+            sched_yield();
+        stat_add(self, BBUF_STAT_BLOCKED, now_ns() - t0);
+    }
+    m = q->size - q->counter < n ? q->size - q->counter : n;
+    copy_in(q, q->in, items, m);
+    q->in = (q->in + m) % q->size;
+    q->counter += m;
+    atomic_fetch_add(&q->nput, 1);
+    spin_unlock(&q->lock, &self->node);
+    if (q->type == BBUF_CAS && atomic_load(&q->cwaiting) > 0)
+        futex_wake(&q->nput, m);
+    return m;
+}
+
+/*
+ * 스핀락으로 보호하는 방식에서 아이템을 최대 n개 꺼내고, 꺼낸 개수를 리턴한다.
+ * 버퍼가 닫혔더라도 남은 아이템은 모두 꺼내고, 닫힌 버퍼가 비었으면 -1을 리턴한다.
+ */
+static int spin_get(bbuf_t *q, bbuf_thread_t *self, int *items, int n)
+{
+    int seen, m;
+    long t0;
+
+    while (true) {
+        spin_lock(&q->lock, &self->node);
+        account_lock(self);
+        if (q->counter > 0)
+            break;
+        seen = atomic_load_explicit(&q->nput, memory_order_relaxed);
+        if (atomic_load(&q->closed)) {
+            spin_unlock(&q->lock, &self->node);
+            return -1;
+        }
+        spin_unlock(&q->lock, &self->node);
+        t0 = now_ns();
+        if (q->type == BBUF_CAS)
+            stat_add(self, BBUF_STAT_SPIN, futex_park(&q->nput, seen, &q->cwaiting));
+        else
+            sched_yield();
+        stat_add(self, BBUF_STAT_BLOCKED, now_ns() - t0);
+    }
+    m = q->counter < n ? q->counter : n;
+    copy_out(q, q->out, items, m);
+    q->out = (q->out + m) % q->size;
+    q->counter -= m;
+    atomic_fetch_add(&q->nget, 1);
+    spin_unlock(&q->lock, &self->node);
+    if (q->type == BBUF_CAS && atomic_load(&q->pwaiting) > 0)
+        futex_wake(&q->nget, m);
+    return m;
+}
+
+/*
+ * BBUF_SEM: 세마포 s를 기다린다. 바로 얻지 못하고 잠들었으면 기다린 시간을 통계에 더한다.
+ */
+static void sem_block(bbuf_thread_t *self, sem_t *s)
+{
+    long t0;
+
+    if (sem_trywait(s) == 0)
+        return;
+    t0 = now_ns();
+    sem_wait(s);
+    stat_add(self, BBUF_STAT_BLOCKED, now_ns() - t0);
+}
+
+/*
+ * BBUF_SEM: 빈 자리를 하나 기다린 다음 추가로 얻을 수 있는 만큼(최대 n개) 기다리지 않고 얻는다.
+ * POSIX 세마포는 한 번에 여러 개를 뺄 수 없으므로 sem_trywait()를 반복하지만,
+ * 뮤텍스는 한 번만 잡고 아이템은 memcpy로 한꺼번에 복사한다.
+ * 깨어났을 때 버퍼가 닫혀 있으면 얻은 자리를 돌려주고(다음 생산자도 깨어나게 된다) -1을 리턴한다.
+ */
+static int sem_put(bbuf_t *q, bbuf_thread_t *self, const int *items, int n)
+{
+    int m = 1;
+
+    sem_block(self, &q->empty);
+    while (m < n && sem_trywait(&q->empty) == 0)
+        m++;
+    if (atomic_load(&q->closed)) {
+        for (int k = 0; k < m; ++k)
+            sem_post(&q->empty);
+        return -1;
+    }
+    sem_block(self, &q->pro_mutex);
+    copy_in(q, q->in, items, m);
+    q->in = (q->in + m) % q->size;
+    atomic_store_explicit(&q->nput, atomic_load_explicit(&q->nput, memory_order_relaxed) + m,
+                          memory_order_release);
+    sem_post(&q->pro_mutex);
+    for (int k = 0; k < m; ++k)
+        sem_post(&q->full);
+    return m;
+}
+
+/*
+ * BBUF_SEM: 채워진 자리를 얻어서 아이템을 꺼낸다. 버퍼가 닫히면 bbuf_close()가 full을 하나 더 올려주는데,
+ * 그 값은 아이템이 아니므로 nput과 nget으로 실제 남은 아이템 수를 세어 그만큼만 꺼낸다.
+ * 남은 값은 다시 올려서 다른 소비자도 깨어나게 하고, 남은 아이템이 없으면 -1을 리턴한다.
+ */
+static int sem_get(bbuf_t *q, bbuf_thread_t *self, int *items, int n)
+{
+    int m = 1, avail;
+
+    sem_block(self, &q->full);
+    while (m < n && sem_trywait(&q->full) == 0)
+        m++;
+    sem_block(self, &q->con_mutex);
+    if (atomic_load(&q->closed)) {
+        avail = (int)((unsigned)atomic_load_explicit(&q->nput, memory_order_acquire) -
+                      (unsigned)atomic_load_explicit(&q->nget, memory_order_relaxed));
+        if (avail < m) {
+            for (int k = avail; k < m; ++k)
+                sem_post(&q->full);
+            m = avail;
+        }
+        if (m == 0) {
+            sem_post(&q->con_mutex);
+            return -1;
+        }
+    }
+    copy_out(q, q->out, items, m);
+    q->out = (q->out + m) % q->size;
+    atomic_store_explicit(&q->nget, atomic_load_explicit(&q->nget, memory_order_relaxed) + m,
+                          memory_order_relaxed);
+    sem_post(&q->con_mutex);
+    for (int k = 0; k < m; ++k)
+        sem_post(&q->empty);
+    return m;
+}
+
+/*
+ * BBUF_FAST: 앞 번호를 받은 스레드가 모두 발행할 때까지 기다렸다가 commit을 next로 옮긴다.
+ * 앞 스레드는 이미 자리를 받아 쓰는 중이므로 잠깐이면 끝나지만, 선점당했을 수 있으므로
+ * 오래 기다리면 CPU를 양보한다. 기다리며 돈 횟수는 통계에 더한다.
+ */
+static void publish(bbuf_thread_t *self, _Atomic uint64_t *commit, uint64_t mine, uint64_t next)
+{
+    unsigned spins = 0;
+    long total = 0;
+
+    while (atomic_load_explicit(commit, memory_order_acquire) != mine) {
+        total++;
+        if (++spins < YIELD_AFTER)
+            cpu_relax();
+        else {
+            spins = 0;
+            sched_yield();
+        }
+    }
+    atomic_store_explicit(commit, next, memory_order_release);
+    stat_add(self, BBUF_STAT_SPIN, total);
+}
+
+/*
+ * BBUF_FAST: futex 세마포 s에서 최대 n개의 값을 얻는다. 값이 없어서 기다렸으면 기다린 시간을,
+ * 기다리며 돈 횟수와 실패한 CAS 횟수는 항상 통계에 더한다.
+ */
+static int fsem_take(bbuf_thread_t *self, fsem_t *s, int n)
+{
+    futex_stat_t st = {0, 0};
+    long t0;
+    int m;
+
+    if ((m = fsem_trywait_n(s, n, &st)) == 0) {
+        t0 = now_ns();
+        m = fsem_wait_n(s, n, &st);
+        stat_add(self, BBUF_STAT_BLOCKED, now_ns() - t0);
+    }
+    stat_add(self, BBUF_STAT_SPIN, (long)st.spins);
+    stat_add(self, BBUF_STAT_FAIL, (long)st.fails);
+    return m;
+}
+
+/*
+ * BBUF_FAST: 빈 자리를 최대 n개 한꺼번에 얻고(원자적 연산 1회), 그만큼의 자리 번호를 받아(1회)
+ * 아이템을 복사한 다음, 번호 순서대로 발행하고 채워진 자리의 수를 한 번에 올린다(1회).
+ * 잠든 소비자가 없으면 커널에 들어가지 않는다. 넣은 개수를 리턴한다.
+ * 깨어났을 때 버퍼가 닫혀 있으면 얻은 자리를 돌려주고 -1을 리턴한다.
+ */
+static int fast_put(bbuf_t *q, bbuf_thread_t *self, const int *items, int n)
+{
+    uint64_t t;
+    int m;
+
+    m = fsem_take(self, &q->fempty, n);
+    if (atomic_load(&q->closed)) {
+        fsem_post(&q->fempty, m);
+        return -1;
+    }
+    t = atomic_fetch_add_explicit(&q->in_claim, m, memory_order_relaxed);
+    copy_in(q, (int)(t % q->size), items, m);
+    publish(self, &q->in_commit, t, t + m);
+    fsem_post(&q->ffull, m);
+    return m;
+}
+
+/*
+ * BBUF_FAST: 채워진 자리를 최대 n개 한꺼번에 얻고, 자리 번호를 받아 아이템을 꺼낸 다음,
+ * 번호 순서대로 자리를 돌려주고 빈 자리의 수를 한 번에 올린다. 꺼낸 개수를 리턴한다.
+ * 버퍼가 닫힌 뒤에는 ffull에 아이템이 아닌 값이 하나 섞여 있으므로, 그 값을 얻은 소비자가 다른 소비자의
+ * 몫인 아이템을 먼저 가져갈 수 있다. 그래서 closed를 검사하지 않고 언제나 발행된 아이템 수(in_commit)를
+ * 넘지 않게 CAS로 번호를 받는다. closed를 본 다음 번호를 받는 사이에 닫히면, 발행되지 않은 자리를 꺼내고
+ * 섞인 값까지 써 버려서 남은 소비자가 깨어나지 못하기 때문이다. 받지 못한 만큼의 값은 다시 올려서
+ * 섞인 값이 다음 소비자에게 넘어가게 하며, 남은 아이템이 없으면 -1을 리턴한다.
+ * 닫히기 전에는 얻은 값만큼 아이템이 발행되어 있으므로 CAS가 경쟁으로 실패할 때만 다시 돈다.
+ */
+static int fast_get(bbuf_t *q, bbuf_thread_t *self, int *items, int n)
+{
+    uint64_t t, limit, avail;
+    int m;
+    long fails = -1;
+
+    m = fsem_take(self, &q->ffull, n);
+    t = atomic_load_explicit(&q->out_claim, memory_order_relaxed);
+    do {
+        fails++;
+        limit = atomic_load_explicit(&q->in_commit, memory_order_acquire);
+        avail = limit > t ? limit - t : 0;
+        if (avail < (uint64_t)m) {
+            fsem_post(&q->ffull, m - (int)avail);
+            m = (int)avail;
+        }
+        if (m == 0) {
+            stat_add(self, BBUF_STAT_FAIL, fails);
+            return -1;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&q->out_claim, &t, t + m,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    stat_add(self, BBUF_STAT_FAIL, fails);
+    copy_out(q, (int)(t % q->size), items, m);
+    publish(self, &q->out_commit, t, t + m);
+    fsem_post(&q->fempty, m);
+    return m;
+}
+
+/*
+ * 방식에 따라 아이템을 최대 n개 넣고 넣은 개수를 리턴한다. 빈 자리가 없으면 생길 때까지 기다린다.
+ */
+static int put_some(bbuf_t *q, bbuf_thread_t *self, const int *items, int n)
+{
+    int m;
+
+    if (q->type != BBUF_SEM && q->type != BBUF_FAST)
+        m = spin_put(q, self, items, n);
+    else {
+        /*
+         * bbuf_close()가 진행 중인 생산자를 기다릴 수 있도록 pactive를 올린 다음 closed를 검사한다.
+         */
+        atomic_fetch_add(&q->pactive, 1);
+        if (atomic_load(&q->closed))
+            m = -1;
+        else
+            m = q->type == BBUF_SEM ? sem_put(q, self, items, n) : fast_put(q, self, items, n);
+        atomic_fetch_sub(&q->pactive, 1);
+    }
+    if (m > 0)
+        stat_add(self, BBUF_STAT_PUT, m);
+    return m;
+}
+
+/*
+ * 방식에 따라 아이템을 최대 n개 꺼내고 꺼낸 개수를 리턴한다. 아이템이 없으면 들어올 때까지 기다린다.
+ */
+static int get_some(bbuf_t *q, bbuf_thread_t *self, int *items, int n)
+{
+    int m;
+
+    switch (q->type) {
+        case BBUF_SEM:
+            m = sem_get(q, self, items, n);
+            break;
+        case BBUF_FAST:
+            m = fast_get(q, self, items, n);
+            break;
+        default:
+            m = spin_get(q, self, items, n);
+    }
+    if (m > 0)
+        stat_add(self, BBUF_STAT_GET, m);
+    return m;
+}
+
+/*
+ * 유한버퍼에 아이템 item을 넣는다. 빈 자리가 없으면 생길 때까지 기다린다.
+ * 버퍼가 닫혔으면 넣지 않고 BBUF_CLOSED를 리턴한다.
+ */
+int bbuf_put(bbuf_t *q, bbuf_thread_t *self, int item)
+{
+    return put_some(q, self, &item, 1) < 0 ? BBUF_CLOSED : BBUF_SUCCESS;
+}
+
+/*
+ * 유한버퍼에서 아이템을 꺼내 *item에 저장한다. 아이템이 없으면 들어올 때까지 기다린다.
+ * 버퍼가 닫혔으면 남은 아이템을 계속 꺼내 주다가, 모두 꺼내고 나면 BBUF_CLOSED를 리턴한다.
+ */
+int bbuf_get(bbuf_t *q, bbuf_thread_t *self, int *item)
+{
+    return get_some(q, self, item, 1) < 0 ? BBUF_CLOSED : BBUF_SUCCESS;
+}
+
+/*
+ * 유한버퍼에 items의 아이템 n개를 순서대로 모두 넣는다.
+ * 빈 자리가 생길 때마다 들어가는 만큼을 한 번의 동기화로 넣으므로, 버퍼보다 큰 묶음도 넣을 수 있다.
+ * 여러 생산자가 동시에 넣으면 묶음이 나뉜 경계에서 다른 생산자의 아이템이 끼어들 수 있다.
+ * 넣는 도중에 버퍼가 닫히면 BBUF_CLOSED를 리턴하며, 그 전까지 넣은 아이템은 소비자에게 전달된다.
+ */
+int bbuf_put_n(bbuf_t *q, bbuf_thread_t *self, const int *items, int n)
+{
+    int done = 0, m;
+
+    while (done < n) {
+        if ((m = put_some(q, self, items + done, n - done)) < 0)
+            return BBUF_CLOSED;
+        done += m;
+    }
+    return BBUF_SUCCESS;
+}
+
+/*
+ * 유한버퍼에서 아이템을 최대 n개 꺼내 items에 저장하고, 꺼낸 개수를 *got에 저장한다.
+ * 아이템이 하나도 없으면 들어올 때까지 기다리고, 있으면 있는 만큼(최대 n개)을 한 번의 동기화로 꺼낸다.
+ */
+int bbuf_get_n(bbuf_t *q, bbuf_thread_t *self, int *items, int n, int *got)
+{
+    *got = n > 0 ? get_some(q, self, items, n) : 0;
+    if (*got < 0) {
+        *got = 0;
+        return BBUF_CLOSED;
+    }
+    return BBUF_SUCCESS;
+}
+
+/*
+ * 유한버퍼를 닫는다. 한 번만 불러야 하며, 생산자나 소비자가 아닌 스레드가 부르는 것이 좋다.
+ * 닫힌 뒤의 넣기는 모두 BBUF_CLOSED로 실패하고, 기다리던 생산자도 깨어나서 BBUF_CLOSED를 받는다.
+ * 소비자는 남은 아이템을 모두 꺼낸 다음 BBUF_CLOSED를 받으므로 넣은 아이템을 잃지 않는다.
+ * 스레드를 철회(pthread_cancel)하지 않으므로 락이나 세마포가 잡힌 채로 남지 않는다.
+ */
+void bbuf_close(bbuf_t *q)
+{
+    unsigned spins = 0;
+
+    atomic_store(&q->closed, 1);
+    switch (q->type) {
+        case BBUF_CAS:
+        case BBUF_SPIN:
+            /*
+             * seq 값을 바꿔서 잠들기 직전인 스레드도 바로 돌아오게 하고, 잠든 스레드는 모두 깨운다.
+             */
+            atomic_fetch_add(&q->nput, 1);
+            atomic_fetch_add(&q->nget, 1);
+            futex_wake(&q->nput, INT_MAX);
+            futex_wake(&q->nget, INT_MAX);
+            break;
+        case BBUF_SEM:
+        case BBUF_FAST:
+            /*
+             * 빈 자리를 하나 올려서 기다리는 생산자를 깨운다. 깨어난 생산자는 자리를 돌려주므로
+             * 줄줄이 모든 생산자가 깨어난다. 진행 중인 생산자가 모두 끝나서 넣은 아이템 수가 확정되면,
+             * 채워진 자리를 하나 올려서 같은 방법으로 소비자를 깨운다.
+             */
+            if (q->type == BBUF_SEM)
+                sem_post(&q->empty);
+            else
+                fsem_post(&q->fempty, 1);
+            while (atomic_load(&q->pactive) > 0) {
+                if (++spins < YIELD_AFTER)
+                    cpu_relax();
+                else {
+                    spins = 0;
+                    sched_yield();
+                }
+            }
+            if (q->type == BBUF_SEM)
+                sem_post(&q->full);
+            else
+                fsem_post(&q->ffull, 1);
+            break;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef BOUNDED_BUFFER_H
+#define BOUNDED_BUFFER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include "spinlock.h"
+#include "futex.h"
+
+#define BBUF_CAS 0
+#define BBUF_SEM 1
+#define BBUF_SPIN 2
+#define BBUF_FAST 3
+#define BBUF_SUCCESS 0
+#define BBUF_FAIL 4
+#define BBUF_CLOSED 5
+#define BBUF_STAT_PUT 0
+#define BBUF_STAT_GET 1
+#define BBUF_STAT_FAIL 2
+#define BBUF_STAT_SPIN 3
+#define BBUF_STAT_BLOCKED 4
+#define BBUF_NSTAT 5
+
+struct bbuf_thread;
+
+/*
+ * 여러 스레드가 공유하는 유한버퍼 구조체 타입
+ *
+ * type은 동기화 방식으로 BBUF_CAS, BBUF_SEM, BBUF_SPIN, BBUF_FAST 중 하나이다.
+ *   BBUF_CAS는 bounded_buffer_cas.c처럼 TTAS 스핀락으로 보호하고, 버퍼가 차거나 비면 futex에서 잠든다.
+ *   BBUF_SEM은 bounded_buffer_sem.c처럼 세마포 네 개로 동기화한다.
+ *   BBUF_SPIN은 MCS 큐 락으로 보호하고, 버퍼가 차거나 비면 락을 풀고 계속 돌면서 기다린다.
+ *   BBUF_FAST는 BBUF_SEM처럼 생산자와 소비자를 따로 동기화하지만 세마포 대신 futex 세마포를 쓰고,
+ *   뮤텍스 대신 원자적 연산 한 번으로 자리 번호를 받는다. 커널은 버퍼가 정말 차거나 비었을 때만 들어간다.
+ * 배열 buffer는 원형 버퍼의 역할을 하며 size는 버퍼의 크기이다.
+ * in과 out은 다음에 넣을 위치와 꺼낼 위치이고, counter는 버퍼에 있는 아이템의 수이다.
+ * nput과 nget은 넣은 횟수와 꺼낸 횟수로 BBUF_CAS에서 잠드는 futex 변수로 쓴다.
+ * BBUF_SEM에서는 넣은 아이템 수와 꺼낸 아이템 수를 세어서 닫힌 버퍼가 비었는지 판단한다.
+ * closed는 bbuf_close()로 버퍼를 닫았으면 1이고, pactive는 BBUF_SEM과 BBUF_FAST에서
+ * 넣기를 진행 중인 생산자의 수이다. 닫을 때 진행 중인 생산자가 모두 끝나기를 기다린다.
+ * pwaiting과 cwaiting은 잠들어 있는 생산자와 소비자의 수이다.
+ * BBUF_FAST에서 생산자는 in_claim에서 자리 번호를 받아 아이템을 쓰고, 앞 번호가 모두 발행되면
+ * in_commit을 자기 다음 번호로 옮겨서 발행한다. 소비자도 out_claim과 out_commit으로 똑같이 한다.
+ * 번호는 64비트라서 넘치지 않으며, 생산자 쪽과 소비자 쪽 변수는 서로 다른 캐시라인에 둔다.
+ * threads는 bbuf_thread_init()으로 등록된 스레드의 목록이고, retired는 등록을 해제한 스레드의
+ * 통계를 모아 둔 것이다. 둘 다 reglock으로 보호한다.
+ */
+typedef struct {
+    int type;                   /* 동기화 방식 */
+    int *buffer;                /* 원형 버퍼 */
+    int size;                   /* 원형 버퍼의 크기 */
+    int in;                     /* 다음에 넣을 위치 */
+    int out;                    /* 다음에 꺼낼 위치 */
+    int counter;                /* 버퍼에 있는 아이템의 수 */
+    spinlock_t lock;            /* BBUF_CAS, BBUF_SPIN: 버퍼를 보호하는 스핀락 */
+    atomic_int nput;            /* BBUF_CAS: 넣은 횟수 (futex) */
+    atomic_int nget;            /* BBUF_CAS: 꺼낸 횟수 (futex) */
+    atomic_int pwaiting;        /* BBUF_CAS: 잠든 생산자의 수 */
+    atomic_int cwaiting;        /* BBUF_CAS: 잠든 소비자의 수 */
+    atomic_int closed;          /* 버퍼가 닫혔으면 1 */
+    atomic_int pactive;         /* BBUF_SEM, BBUF_FAST: 넣기를 진행 중인 생산자의 수 */
+    sem_t empty;                /* BBUF_SEM: 빈 자리의 수 */
+    sem_t full;                 /* BBUF_SEM: 채워진 자리의 수 */
+    sem_t pro_mutex;            /* BBUF_SEM: 생산자 사이의 상호배타 */
+    sem_t con_mutex;            /* BBUF_SEM: 소비자 사이의 상호배타 */
+    _Alignas(SPIN_CACHELINE) fsem_t fempty;             /* BBUF_FAST: 빈 자리의 수 */
+    _Atomic uint64_t in_claim;                          /* BBUF_FAST: 생산자가 받을 다음 번호 */
+    _Atomic uint64_t in_commit;                         /* BBUF_FAST: 발행된 아이템의 수 */
+    _Alignas(SPIN_CACHELINE) fsem_t ffull;              /* BBUF_FAST: 채워진 자리의 수 */
+    _Atomic uint64_t out_claim;                         /* BBUF_FAST: 소비자가 받을 다음 번호 */
+    _Atomic uint64_t out_commit;                        /* BBUF_FAST: 돌려준 자리의 수 */
+    spinlock_t reglock;                                 /* threads와 retired를 보호하는 락 */
+    struct bbuf_thread *threads;                        /* 등록된 스레드의 목록 */
+    long retired[BBUF_NSTAT];                           /* 등록을 해제한 스레드의 통계 합 */
+} bbuf_t;
+
+/*
+ * 유한버퍼를 사용하는 스레드마다 하나씩 가지는 정보
+ *
+ * node는 스핀락이 큐 락일 때 대기열에 넣을 스레드 자신의 노드이다.
+ * stat은 이 스레드의 통계로, BBUF_STAT_PUT과 BBUF_STAT_GET은 넣고 꺼낸 아이템 수,
+ * BBUF_STAT_FAIL은 실패한 CAS 횟수, BBUF_STAT_SPIN은 락이나 자리를 기다리며 돈 횟수,
+ * BBUF_STAT_BLOCKED는 버퍼가 차거나 비어서(BBUF_SEM은 뮤텍스 세마포도 포함) 잠들거나
+ * CPU를 양보하며 기다린 시간(나노초)이다.
+ * 이 스레드만 고치고 다른 스레드는 읽기만 하므로 읽기-수정-쓰기 연산 없이 relaxed로 읽고 쓰며,
+ * 다른 스레드의 통계와 같은 캐시라인을 쓰지 않도록 캐시라인 경계에 맞춘다.
+ */
+typedef struct bbuf_thread {
+    _Alignas(SPIN_CACHELINE) _Atomic long stat[BBUF_NSTAT];     /* 이 스레드의 통계 */
+    spin_node_t node;                                           /* 스핀락 대기열 노드 */
+    struct bbuf_thread *next;                                   /* 등록된 다음 스레드 */
+} bbuf_thread_t;
+
+int bbuf_init(bbuf_t *q, int type, int size);
+void bbuf_destroy(bbuf_t *q);
+int bbuf_thread_init(bbuf_t *q, bbuf_thread_t *self);
+void bbuf_thread_destroy(bbuf_t *q, bbuf_thread_t *self);
+void bbuf_thread_stats(bbuf_thread_t *self, long *stat);
+void bbuf_stats(bbuf_t *q, long *stat);
+int bbuf_put(bbuf_t *q, bbuf_thread_t *self, int item);
+int bbuf_get(bbuf_t *q, bbuf_thread_t *self, int *item);
+int bbuf_put_n(bbuf_t *q, bbuf_thread_t *self, const int *items, int n);
+int bbuf_get_n(bbuf_t *q, bbuf_thread_t *self, int *items, int n, int *got);
+void bbuf_close(bbuf_t *q);
+
+#endif
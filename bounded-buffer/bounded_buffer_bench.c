@@ -0,0 +1,372 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "bounded_buffer.h"
+
+#define NPRODUCER 4
+#define NCONSUMER 4
+#define BUFSIZE 10
+#define DURATION 1000
+#define MAXBATCH 4096
+/*
+ * 지연시간 히스토그램: 16 나노초까지는 1 나노초 단위로, 그 이상은 2의 거듭제곱 구간마다
+ * 16개씩 나눠서 센다. 상대 오차는 1/16 이내이며 2^40 나노초까지 기록할 수 있다.
+ */
+#define SUBBITS 4
+#define NSUB (1 << SUBBITS)
+#define NBUCKET ((40 - SUBBITS + 1) * NSUB)
+#define CACHELINE 64
+
+/*
+ * 스레드마다 하나씩 가지는 측정 정보
+ *
+ * 다른 스레드의 기록과 캐시라인을 공유하지 않도록 캐시라인 경계에 맞춘다.
+ * 측정하는 동안에는 출력을 전혀 하지 않고 이 구조체에만 기록한다.
+ */
+typedef struct {
+    _Alignas(CACHELINE) int id;     /* 스레드 번호 */
+    bool producer;                  /* 생산자이면 true, 소비자이면 false */
+    int cpu;                        /* 고정할 CPU 번호, -1이면 고정하지 않음 */
+    long ops;                       /* 처리한 아이템의 수 */
+    long calls;                     /* 넣기 또는 꺼내기를 부른 횟수 */
+    long maxlat;                    /* 가장 긴 연산 시간 (나노초) */
+    long stat[BBUF_NSTAT];          /* 끝날 때 복사한 유한버퍼의 스레드 통계 */
+    long hist[NBUCKET];             /* 연산 시간의 히스토그램 */
+} worker_t;
+
+/*
+ * 모든 스레드가 공유하는 실험 환경
+ */
+bbuf_t queue;
+pthread_barrier_t barrier;
+atomic_bool stop = false;
+int batch = 1;
+
+static long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/*
+ * 나노초 단위의 지연시간 v가 들어갈 히스토그램 칸의 번호를 구한다.
+ */
+static int bucket_of(long v)
+{
+    int e;
+
+    if (v < NSUB)
+        return (int)v;
+    e = 63 - __builtin_clzl((unsigned long)v);
+    if (e >= 40)
+        return NBUCKET - 1;
+    return (e - SUBBITS + 1) * NSUB + (int)((v >> (e - SUBBITS)) & (NSUB - 1));
+}
+
+/*
+ * 히스토그램 칸 b에 들어가는 가장 작은 값을 구한다.
+ */
+static long bucket_low(int b)
+{
+    int e;
+
+    if (b < NSUB)
+        return b;
+    e = b / NSUB + SUBBITS - 1;
+    return (1L << e) + ((long)(b % NSUB) << (e - SUBBITS));
+}
+
+/*
+ * 한 번의 호출로 아이템 n개를 처리하는 데 lat 나노초가 걸렸음을 기록한다.
+ */
+static void record(worker_t *w, long lat, int n)
+{
+    w->ops += n;
+    w->calls++;
+    w->hist[bucket_of(lat)]++;
+    if (lat > w->maxlat)
+        w->maxlat = lat;
+}
+
+/*
+ * 스레드를 w->cpu에 고정한다.
+ */
+static void pin(worker_t *w)
+{
+    cpu_set_t set;
+
+    if (w->cpu < 0)
+        return;
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/*
+ * 생산자는 stop이 true가 될 때까지 아이템을 넣고, 매번 걸린 시간을 기록한다.
+ * batch가 1보다 크면 batch 개씩 묶어서 bbuf_put_n()으로 넣는다.
+ */
+void *producer(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    bbuf_thread_t self;
+    long t0, t1;
+    int item = 0, items[MAXBATCH];
+
+    pin(w);
+    bbuf_thread_init(&queue, &self);
+    pthread_barrier_wait(&barrier);
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        if (batch == 1) {
+            t0 = now_ns();
+            bbuf_put(&queue, &self, item);
+            t1 = now_ns();
+        }
+        else {
+            for (int k = 0; k < batch; ++k)
+                items[k] = (item + k) & 0x7fffffff;
+            t0 = now_ns();
+            bbuf_put_n(&queue, &self, items, batch);
+            t1 = now_ns();
+        }
+        record(w, t1 - t0, batch);
+        item = (item + batch) & 0x7fffffff;
+    }
+    bbuf_thread_stats(&self, w->stat);
+    bbuf_thread_destroy(&queue, &self);
+    pthread_exit(NULL);
+}
+
+/*
+ * 소비자는 버퍼가 닫히고 비어서 BBUF_CLOSED를 받을 때까지 아이템을 꺼내고, 매번 걸린 시간을 기록한다.
+ * 생산자가 모두 끝난 다음에 메인 스레드가 버퍼를 닫는다.
+ * batch가 1보다 크면 bbuf_get_n()으로 최대 batch 개씩 꺼낸다.
+ */
+void *consumer(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    bbuf_thread_t self;
+    long t0, t1;
+    int items[MAXBATCH], got, r;
+
+    pin(w);
+    bbuf_thread_init(&queue, &self);
+    pthread_barrier_wait(&barrier);
+    while (true) {
+        t0 = now_ns();
+        if (batch == 1) {
+            r = bbuf_get(&queue, &self, items);
+            got = 1;
+        }
+        else
+            r = bbuf_get_n(&queue, &self, items, batch, &got);
+        t1 = now_ns();
+        if (r == BBUF_CLOSED)
+            break;
+        record(w, t1 - t0, got);
+    }
+    bbuf_thread_stats(&self, w->stat);
+    bbuf_thread_destroy(&queue, &self);
+    pthread_exit(NULL);
+}
+
+/*
+ * 히스토그램 hist에서 q 분위수(0 < q <= 1)를 구한다.
+ */
+static long percentile(const long *hist, long total, double q)
+{
+    long need = (long)(q * total + 0.5), sum = 0;
+
+    if (need < 1)
+        need = 1;
+    for (int b = 0; b < NBUCKET; ++b) {
+        sum += hist[b];
+        if (sum >= need)
+            return bucket_low(b);
+    }
+    return bucket_low(NBUCKET - 1);
+}
+
+/*
+ * 한 역할(생산자 또는 소비자)의 지연시간 분포와 공정성을 출력한다.
+ * 공정성은 Jain의 지표 (sum x)^2 / (n * sum x^2)로 나타내며, 1이면 모든 스레드가 같은 양을 처리했다.
+ * 스레드마다 실패한 CAS 횟수, 기다리며 돈 횟수, 잠들거나 양보하며 기다린 시간도 출력해서
+ * 어느 스레드가 굶주리는지 볼 수 있게 한다.
+ */
+static void report_role(const char *name, worker_t *w, int n)
+{
+    long hist[NBUCKET] = {0,};
+    long total = 0, calls = 0, maxlat = 0, minops = -1, maxops = 0;
+    double sum2 = 0;
+
+    if (n == 0)
+        return;
+    for (int i = 0; i < n; ++i) {
+        for (int b = 0; b < NBUCKET; ++b)
+            hist[b] += w[i].hist[b];
+        total += w[i].ops;
+        calls += w[i].calls;
+        sum2 += (double)w[i].ops * w[i].ops;
+        if (w[i].maxlat > maxlat)
+            maxlat = w[i].maxlat;
+        if (minops < 0 || w[i].ops < minops)
+            minops = w[i].ops;
+        if (w[i].ops > maxops)
+            maxops = w[i].ops;
+    }
+    printf("  %-8s ops=%ld p50=%ldns p90=%ldns p99=%ldns p99.9=%ldns max=%ldns\n", name, total,
+           percentile(hist, calls, 0.5), percentile(hist, calls, 0.9),
+           percentile(hist, calls, 0.99), percentile(hist, calls, 0.999), maxlat);
+    printf("  %-8s fairness=%.4f min/max=%ld/%ld per-thread:", name,
+           sum2 > 0 ? (double)total * total / (n * sum2) : 1.0, minops, maxops);
+    for (int i = 0; i < n; ++i)
+        printf(" %ld", w[i].ops);
+    printf("\n");
+    printf("  %-8s per-thread cas-fails/spins/blocked:", name);
+    for (int i = 0; i < n; ++i)
+        printf(" %ld/%ld/%.1fms", w[i].stat[BBUF_STAT_FAIL], w[i].stat[BBUF_STAT_SPIN],
+               w[i].stat[BBUF_STAT_BLOCKED] / 1e6);
+    printf("\n");
+}
+
+/*
+ * type 방식의 유한버퍼 하나를 측정하고 결과를 출력한다.
+ */
+static int run(int type, int np, int nc, int size, int duration, bool pinned)
+{
+    static const char *name[] = {"cas", "sem", "spin", "fast"};
+    pthread_t *tid;
+    worker_t *w;
+    long start, elapsed, produced = 0, stat[BBUF_NSTAT];
+    int i, n = np + nc;
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    tid = (pthread_t *)malloc(sizeof(pthread_t)*n);
+    w = (worker_t *)aligned_alloc(CACHELINE, sizeof(worker_t)*n);
+    if (tid == NULL || w == NULL || bbuf_init(&queue, type, size) != BBUF_SUCCESS) {
+        fprintf(stderr, "initialization error\n");
+        return -1;
+    }
+    memset(w, 0, sizeof(worker_t)*n);
+    atomic_store(&stop, false);
+    pthread_barrier_init(&barrier, NULL, n + 1);
+    /*
+     * 앞의 np 개는 생산자, 나머지 nc 개는 소비자이다. CPU는 돌아가면서 하나씩 배정한다.
+     */
+    for (i = 0; i < n; ++i) {
+        w[i].id = i;
+        w[i].producer = i < np;
+        w[i].cpu = pinned ? i % ncpu : -1;
+        if (pthread_create(tid+i, NULL, w[i].producer ? producer : consumer, w+i) != 0) {
+            fprintf(stderr, "pthread_create error\n");
+            exit(-1);
+        }
+    }
+    pthread_barrier_wait(&barrier);
+    start = now_ns();
+    usleep(duration * 1000);
+    atomic_store(&stop, true);
+    /*
+     * 생산자가 모두 끝나면 버퍼를 닫는다. 소비자는 남은 아이템을 비우고 끝난다.
+     */
+    for (i = 0; i < np; ++i)
+        pthread_join(tid[i], NULL);
+    elapsed = now_ns() - start;
+    bbuf_close(&queue);
+    for (i = np; i < n; ++i)
+        pthread_join(tid[i], NULL);
+    for (i = 0; i < np; ++i)
+        produced += w[i].ops;
+    printf("%s: producers=%d consumers=%d capacity=%d batch=%d duration=%.3fs throughput=%.0f items/s\n",
+           name[type], np, nc, size, batch, elapsed / 1e9, produced / (elapsed / 1e9));
+    report_role("producer", w, np);
+    report_role("consumer", w + np, nc);
+    bbuf_stats(&queue, stat);
+    printf("  total    put=%ld get=%ld cas-fails=%ld spins=%ld blocked=%.1fms\n",
+           stat[BBUF_STAT_PUT], stat[BBUF_STAT_GET], stat[BBUF_STAT_FAIL], stat[BBUF_STAT_SPIN],
+           stat[BBUF_STAT_BLOCKED] / 1e6);
+    pthread_barrier_destroy(&barrier);
+    bbuf_destroy(&queue);
+    free(w);
+    free(tid);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q cas|sem|spin|fast|all] [-p producers] [-c consumers]"
+                    " [-b capacity] [-k batch] [-d milliseconds] [-u]\n"
+                    "  -k  move items in batches with bbuf_put_n()/bbuf_get_n()\n"
+                    "  -u  do not pin threads to CPUs\n", prog);
+    exit(-1);
+}
+
+/*
+ * 메인 함수는 인자로 받은 설정대로 유한버퍼를 하나씩 또는 모두 측정한다.
+ */
+int main(int argc, char *argv[])
+{
+    int opt, type = -1;
+    int np = NPRODUCER, nc = NCONSUMER, size = BUFSIZE, duration = DURATION;
+    bool pinned = true;
+
+    while ((opt = getopt(argc, argv, "q:p:c:b:k:d:u")) != -1) {
+        switch (opt) {
+            case 'q':
+                if (strcmp(optarg, "cas") == 0)
+                    type = BBUF_CAS;
+                else if (strcmp(optarg, "sem") == 0)
+                    type = BBUF_SEM;
+                else if (strcmp(optarg, "spin") == 0)
+                    type = BBUF_SPIN;
+                else if (strcmp(optarg, "fast") == 0)
+                    type = BBUF_FAST;
+                else if (strcmp(optarg, "all") == 0)
+                    type = -1;
+                else
+                    usage(argv[0]);
+                break;
+            case 'p':
+                np = atoi(optarg);
+                break;
+            case 'c':
+                nc = atoi(optarg);
+                break;
+            case 'b':
+                size = atoi(optarg);
+                break;
+            case 'k':
+                batch = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'u':
+                pinned = false;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (np <= 0 || nc <= 0 || size <= 0 || duration <= 0 || batch <= 0 || batch > MAXBATCH)
+        usage(argv[0]);
+    if (type >= 0)
+        return run(type, np, nc, size, duration, pinned);
+    for (type = BBUF_CAS; type <= BBUF_FAST; ++type)
+        if (run(type, np, nc, size, duration, pinned) != 0)
+            return -1;
+    return 0;
+}
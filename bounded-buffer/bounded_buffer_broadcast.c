@@ -0,0 +1,145 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "broadcast_ring.h"
+
+#define NP 2
+#define RINGSIZE 1024
+#define DONE -1
+#define AUDIT 0
+#define METRICS 1
+#define STORAGE 2
+#define NC 3
+/*
+ * 생산자와 소비자가 공유할 방송 원형 버퍼
+ */
+bring_t ring;
+/*
+ * 생산된 아이템의 개수와 합, 소비자마다 본 아이템의 개수와 합을 기록하기 위한 변수
+ * 방송 버퍼에서는 모든 소비자가 모든 아이템을 보므로 소비자마다 생산자와 같은 값이 나와야 한다.
+ * storage 단계는 audit 단계가 처리한 아이템만 보므로, 보기 전에 audit가 처리했는지 검사한다.
+ */
+atomic_long produced = 0;
+atomic_long produced_sum = 0;
+long seen[NC], seen_sum[NC];
+long unordered = 0;
+int cid[NC];
+/*
+ * alive 값이 false가 될 때까지 생산자 스레드 내의 루프가 무한히 반복된다.
+ */
+atomic_bool alive = true;
+/*
+ * audit 단계가 처리를 끝낸 아이템의 개수 (storage 단계가 검사에 사용한다)
+ */
+atomic_long audited = 0;
+
+/*
+ * 생산자 스레드로 실행할 함수이다. 아이템(난수)을 버퍼의 자리에 직접 쓰고 발행한다.
+ * 끝날 때는 종료 신호 DONE을 발행한다. 모든 소비자가 이 신호를 본다.
+ */
+void *producer(void *arg)
+{
+    unsigned seed = (unsigned)time(NULL) ^ (unsigned)(*(int *)arg * 7919);
+    long n = 0, sum = 0;
+    uint64_t seq;
+    int *slot;
+
+    while (alive) {
+        slot = bring_claim(&ring, &seq);
+        *slot = rand_r(&seed) % 1000;
+        sum += *slot;
+        bring_publish(&ring, seq);
+        n++;
+    }
+    slot = bring_claim(&ring, &seq);
+    *slot = DONE;
+    bring_publish(&ring, seq);
+    atomic_fetch_add(&produced, n);
+    atomic_fetch_add(&produced_sum, sum);
+    pthread_exit(NULL);
+}
+
+/*
+ * 소비자 스레드로 실행할 함수이다. 자기 커서부터 읽을 수 있는 아이템을 버퍼 안에서 그대로 읽고
+ * 커서를 옮긴다. 생산자 수만큼 DONE을 보면 끝난다.
+ */
+void *consumer(void *arg)
+{
+    int i = *(int *)arg;
+    const int *items;
+    size_t n;
+    int done = 0;
+
+    while (done < NP) {
+        items = bring_peek(&ring, cid[i], &n);
+        for (size_t k = 0; k < n; ++k) {
+            if (items[k] == DONE) {
+                done++;
+                continue;
+            }
+            if (i == STORAGE && seen[i] >= atomic_load(&audited))
+                unordered++;
+            seen[i]++;
+            seen_sum[i] += items[k];
+        }
+        if (i == AUDIT)
+            atomic_store(&audited, seen[i]);
+        bring_release(&ring, cid[i], n);
+    }
+    pthread_exit(NULL);
+}
+
+int main(void)
+{
+    static const char *name[NC] = {"audit", "metrics", "storage"};
+    pthread_t tid[NC + NP];
+    int i, id[NC + NP], dep;
+    struct timespec start, end;
+    double sec;
+
+    if (bring_init(&ring, RINGSIZE) != BRING_SUCCESS) {
+        fprintf(stderr, "bring_init error\n");
+        exit(-1);
+    }
+    /*
+     * audit와 metrics는 생산자가 발행한 아이템을 바로 보고, storage는 audit가 처리한 아이템만 본다.
+     * 생산자는 metrics와 storage 중 느린 쪽을 넘지 못한다.
+     */
+    cid[AUDIT] = bring_add_consumer(&ring, NULL, 0);
+    cid[METRICS] = bring_add_consumer(&ring, NULL, 0);
+    dep = cid[AUDIT];
+    cid[STORAGE] = bring_add_consumer(&ring, &dep, 1);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NC + NP; ++i) {
+        id[i] = i;
+        pthread_create(tid+i, NULL, i < NC ? consumer : producer, id+i);
+    }
+    /*
+     * 스레드가 일하는 동안 1초 쉰 다음, 생산자를 끝낸다. 소비자는 남은 아이템을 모두 보고 끝난다.
+     */
+    sleep(1);
+    alive = false;
+    for (i = 0; i < NC + NP; ++i)
+        pthread_join(tid[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    bring_destroy(&ring);
+    /*
+     * 생산된 아이템의 개수와 합, 소비자마다 본 아이템의 개수와 합을 출력한다.
+     */
+    printf("Total %ld items were produced (sum %ld, %.0f items/s).\n", produced, produced_sum, produced / sec);
+    for (i = 0; i < NC; ++i)
+        printf("%-8s saw %ld items (sum %ld)%s\n", name[i], seen[i], seen_sum[i],
+               seen[i] == produced && seen_sum[i] == produced_sum ? "" : " MISMATCH");
+    printf("storage saw %ld items before audit finished them.\n", unordered);
+    return 0;
+}
@@ -6,11 +6,21 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <limits.h>
 #include <stdatomic.h>
 #include <pthread.h>
+#include "spinlock.h"
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <sched.h>
+#endif
 
 #define N 8
 #define BUFSIZE 10
+#define SPINCOUNT 128
+#define LOCKTYPE SPIN_TTAS
 #define RED "\e[0;31m"
 #define RESET "\e[0m"
 /*
@@ -26,13 +36,65 @@ int counter = 0;
 int produced = 0;
 int consumed = 0;
 /*
- * 스핀락으로 사용한 원자변수 lock은 모든 생산자와 소비자가 공유한다.
+ * 스핀락 lock은 모든 생산자와 소비자가 공유한다.
+ * LOCKTYPE을 SPIN_TTAS, SPIN_TICKET, SPIN_MCS, SPIN_CLH 중 하나로 바꿔서 비교할 수 있다.
  */
-atomic_int lock = 0;
+spinlock_t lock;
+/*
+ * nput과 nget은 지금까지 버퍼에 넣은 횟수와 꺼낸 횟수로 head/tail 위치를 나타낸다.
+ * 버퍼가 가득 찬 생산자는 nget에서, 버퍼가 빈 소비자는 nput에서 잠든다(futex).
+ * pwaiting과 cwaiting은 잠들어 있는 생산자와 소비자의 수로, 0이면 깨우는 시스템 호출을 생략한다.
+ */
+atomic_int nput = 0;
+atomic_int nget = 0;
+atomic_int pwaiting = 0;
+atomic_int cwaiting = 0;
 /*
  * alive 값이 false가 될 때까지 스레드 내의 루프가 무한히 반복된다.
  */
-bool alive = true;
+atomic_bool alive = true;
+
+/*
+ * *addr 값이 아직 val이면 다른 스레드가 깨울 때까지 잠든다.
+ * 잠들기 전에 값이 바뀌었으면 즉시 리턴하므로 깨우는 신호를 놓치지 않는다.
+ */
+static void futex_wait(atomic_int *addr, int val)
+{
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+    if (atomic_load(addr) == val)
+        sched_yield();
+#endif
+}
+
+/*
+ * addr에서 잠들어 있는 스레드를 최대 n개 깨운다.
+ */
+static void futex_wake(atomic_int *addr, int n)
+{
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+    (void)addr; (void)n;
+#endif
+}
+
+/*
+ * seq 값이 seen에서 바뀌기를 기다린다. 먼저 SPINCOUNT 번 짧게 돌아본 다음,
+ * 그래도 바뀌지 않으면 waiting을 증가시키고 futex에서 잠든다.
+ * waiting을 증가시킨 후에 alive를 다시 검사해야 종료 신호를 놓치지 않는다.
+ */
+static void park(atomic_int *seq, int seen, atomic_int *waiting)
+{
+    for (int k = 0; k < SPINCOUNT; ++k)
+        if (atomic_load_explicit(seq, memory_order_relaxed) != seen)
+            return;
+    atomic_fetch_add(waiting, 1);
+    if (alive)
+        futex_wait(seq, seen);
+    atomic_fetch_sub(waiting, 1);
+}
 
 /*
  * 생산자 스레드로 실행할 함수이다. 아이템(난수)을 생성하여 버퍼에 넣는다.
@@ -41,12 +103,15 @@ void *producer(void *arg)
 {
     int i = *(int *)arg;
     int item;
-    int expected = 0;
-    
+    int seen;
+    spin_node_t node;
+
+    if (spin_node_init(&node) != SPIN_SUCCESS)
+        pthread_exit(NULL);
     while (alive) {
         /*
          * 스핀락을 사용하여 먼저 락을 획득한 다음 버퍼에 빈 공간이 있는지 검사한다.
-         * 버퍼에 빈 공간이 없으면 락을 풀고 다시 스핀락을 얻기 위해 루프를 반복한다.
+         * 버퍼에 빈 공간이 없으면 락을 풀고 소비자가 nget을 바꿀 때까지 기다린 다음 루프를 반복한다.
          * 빈 공간이 있으면 루프를 빠져 나와 생산하기 위해 임계구역으로 들어간다.
          */
         while (true) {
@@ -55,15 +120,18 @@ void *producer(void *arg)
              * 그 이유는 counter 값이 BUFSIZE인 상태에서 모든 소비자가 종료되면
              * 생산자는 이 while 루프를 빠저나오지 못해서 교착상태에 빠진다.
              */
-            if (!alive)
+            if (!alive) {
+                spin_node_destroy(&node);
                 pthread_exit(NULL);
+            }
             /*
              * 임계구역에 진입하기 전에 락을 획득한다. 성공하면 루프를 빠져 나간다.
              */
-            while(!atomic_compare_exchange_strong(&lock, &expected, 1))
-                expected = 0;
+            spin_lock(&lock, &node);
             if (counter == BUFSIZE) {
-                lock = 0;
+                seen = nget;
+                spin_unlock(&lock, &node);
+                park(&nget, seen, &pwaiting);
                 continue;
             }
             else
@@ -77,15 +145,20 @@ void *producer(void *arg)
         in = (in + 1) % BUFSIZE;
         counter++;
         produced++;
+        atomic_fetch_add(&nput, 1);
         /*
          * 임계구역에서 나왔으므로 락을 푼다.
+         * 빈 버퍼에서 잠든 소비자가 있으면 하나만 깨운다.
          */
-        lock = 0;
+        spin_unlock(&lock, &node);
+        if (cwaiting > 0)
+            futex_wake(&nput, 1);
         /*
          * 생산한 아이템을 출력한다.
          */
         printf("<P%d,%d>\n", i, item);
     }
+    spin_node_destroy(&node);
     pthread_exit(NULL);
 }
 
@@ -96,12 +169,15 @@ void *consumer(void *arg)
 {
     int i = *(int *)arg;
     int item;
-    int expected = 0;
-    
+    int seen;
+    spin_node_t node;
+
+    if (spin_node_init(&node) != SPIN_SUCCESS)
+        pthread_exit(NULL);
     while (alive) {
         /*
          * 스핀락을 사용하여 먼저 락을 획득한 다음 버퍼에 아이템이 있는지 검사한다.
-         * 버퍼에 아이템이 없으면 락을 풀고 다시 스핀락을 얻기 위해 루프를 반복한다.
+         * 버퍼에 아이템이 없으면 락을 풀고 생산자가 nput을 바꿀 때까지 기다린 다음 루프를 반복한다.
          * 아이템이 있으면 루프를 빠져 나와 소비하기 위해 임계구역으로 들어간다.
          */
         while (true) {
@@ -110,15 +186,18 @@ void *consumer(void *arg)
              * 그 이유는 counter 값이 0인 상태에서 모든 생산자가 종료되면
              * 소비자는 이 while 루프를 빠저나오지 못해서 교착상태에 빠진다.
              */
-            if (!alive)
+            if (!alive) {
+                spin_node_destroy(&node);
                 pthread_exit(NULL);
+            }
             /*
              * 임계구역에 진입하기 전에 락을 획득한다. 성공하면 루프를 빠져 나간다.
              */
-            while(!atomic_compare_exchange_strong(&lock, &expected, 1))
-                expected = 0;
+            spin_lock(&lock, &node);
             if (counter == 0) {
-                lock = 0;
+                seen = nput;
+                spin_unlock(&lock, &node);
+                park(&nput, seen, &cwaiting);
                 continue;
             }
             else
@@ -131,15 +210,20 @@ void *consumer(void *arg)
         out = (out + 1) % BUFSIZE;
         counter--;
         consumed++;
+        atomic_fetch_add(&nget, 1);
         /*
          * 임계구역에서 나왔으므로 락을 푼다.
+         * 가득 찬 버퍼에서 잠든 생산자가 있으면 하나만 깨운다.
          */
-        lock = 0;
+        spin_unlock(&lock, &node);
+        if (pwaiting > 0)
+            futex_wake(&nget, 1);
         /*
          * 소비할 아이템을 빨간색으로 출력한다.
          */
         printf(RED"<C%d,%d>"RESET"\n", i, item);
     }
+    spin_node_destroy(&node);
     pthread_exit(NULL);
 }
 
@@ -148,6 +232,13 @@ int main(void)
     pthread_t tid[N];
     int i, id[N];
 
+    /*
+     * 생산자와 소비자가 공유할 스핀락을 초기화한다.
+     */
+    if (spinlock_init(&lock, LOCKTYPE) != SPIN_SUCCESS) {
+        fprintf(stderr, "spinlock_init error\n");
+        exit(-1);
+    }
     /*
      * N/2 개의 소비자 스레드를 생성한다.
      */
@@ -171,11 +262,20 @@ int main(void)
      * 스레드가 자연스럽게 무한 루프를 빠져나올 수 있게 한다.
      */
     alive = false;
+    /*
+     * futex에서 잠든 스레드가 있을 수 있으므로 nput과 nget 값을 바꾸고 모두 깨운다.
+     * 값을 바꿔두면 아직 잠들기 직전인 스레드도 futex_wait에서 바로 돌아온다.
+     */
+    atomic_fetch_add(&nput, 1);
+    atomic_fetch_add(&nget, 1);
+    futex_wake(&nput, INT_MAX);
+    futex_wake(&nget, INT_MAX);
     /*
      * 자식 스레드가 종료될 때까지 기다린다.
      */
     for (i = 0; i < N; ++i)
         pthread_join(tid[i], NULL);
+    spinlock_destroy(&lock);
     /*
      * 생산된 아이템의 개수와 소비된 아이템의 개수를 출력한다.
      */
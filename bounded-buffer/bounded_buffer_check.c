@@ -0,0 +1,172 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "bounded_buffer.h"
+
+#define NPRODUCER 4
+#define NCONSUMER 4
+#define BUFSIZE 4
+#define NROUND 200
+#define MAXITEM (1 << 16)
+#define MAXBATCH 8
+#define HANG 3000
+
+/*
+ * 경쟁 중에 유한버퍼를 닫는 것을 검사하는 프로그램
+ *
+ * 라운드마다 작은 버퍼를 만들어 생산자와 소비자를 돌리다가, 무작위로 짧게 기다린 다음 bbuf_close()를 부른다.
+ * 생산자 p는 p*MAXITEM부터 차례로 번호를 넣으며 BBUF_SUCCESS를 받은 아이템의 수를 put[p]에 센다.
+ * 소비자는 bbuf_get_n()으로 무작위 개수씩 꺼내며 꺼낸 번호마다 got[]를 올린다.
+ * 버퍼는 처음에 -1로 채워 두므로, 발행되지 않은 자리를 꺼내면 -1이나 이미 꺼낸 번호가 나온다.
+ * 라운드가 끝나면 넣은 아이템은 모두 정확히 한 번 꺼냈어야 하고, 넣지 않은 번호는 나오지 않아야 한다.
+ * 소비자가 HANG 밀리초 안에 모두 BBUF_CLOSED를 받지 못하면 깨어나지 못한 소비자가 있는 것이다.
+ */
+bbuf_t queue;
+long put[NPRODUCER];
+atomic_uchar got[NPRODUCER*MAXITEM];
+atomic_long phantom;
+atomic_int finished;
+int np = NPRODUCER, nc = NCONSUMER;
+
+void *producer(void *arg)
+{
+    int p = (int)(long)arg;
+    bbuf_thread_t self;
+
+    if (bbuf_thread_init(&queue, &self) != BBUF_SUCCESS)
+        pthread_exit(NULL);
+    put[p] = 0;
+    while (put[p] < MAXITEM && bbuf_put(&queue, &self, p*MAXITEM + (int)put[p]) == BBUF_SUCCESS)
+        put[p]++;
+    bbuf_thread_destroy(&queue, &self);
+    pthread_exit(NULL);
+}
+
+void *consumer(void *arg)
+{
+    unsigned seed = (unsigned)(long)arg;
+    int items[MAXBATCH], n;
+    bbuf_thread_t self;
+
+    if (bbuf_thread_init(&queue, &self) == BBUF_SUCCESS) {
+        while (bbuf_get_n(&queue, &self, items, 1 + rand_r(&seed) % MAXBATCH, &n) == BBUF_SUCCESS)
+            for (int i = 0; i < n; ++i) {
+                if (items[i] < 0 || items[i] >= np*MAXITEM)
+                    atomic_fetch_add(&phantom, 1);
+                else
+                    atomic_fetch_add(&got[items[i]], 1);
+            }
+        bbuf_thread_destroy(&queue, &self);
+    }
+    atomic_fetch_add(&finished, 1);
+    pthread_exit(NULL);
+}
+
+/*
+ * type 방식으로 라운드를 rounds 번 돌리고, 문제가 없으면 true를 리턴한다.
+ */
+static bool check(const char *name, int type, int rounds)
+{
+    pthread_t tid[np + nc];
+    unsigned seed = 1;
+    long total = 0, lost = 0, dup = 0;
+    int i, p, r, waited;
+
+    atomic_store(&phantom, 0);
+    for (r = 0; r < rounds; ++r) {
+        if (bbuf_init(&queue, type, BUFSIZE) != BBUF_SUCCESS) {
+            fprintf(stderr, "bbuf_init error\n");
+            exit(-1);
+        }
+        memset(queue.buffer, 0xff, sizeof(int)*BUFSIZE);
+        memset(got, 0, sizeof(got));
+        atomic_store(&finished, 0);
+        for (i = 0; i < np + nc; ++i)
+            pthread_create(&tid[i], NULL, i < np ? producer : consumer, (void *)(long)(i < np ? i : r*nc + i));
+        usleep(rand_r(&seed) % 2000);
+        bbuf_close(&queue);
+        for (waited = 0; atomic_load(&finished) < nc; waited += 10) {
+            if (waited >= HANG) {
+                printf("%s,%d,%ld,%ld,%ld,%ld,hang\n", name, r, total, atomic_load(&phantom), dup, lost);
+                exit(1);
+            }
+            usleep(10000);
+        }
+        for (i = 0; i < np + nc; ++i)
+            pthread_join(tid[i], NULL);
+        for (p = 0; p < np; ++p) {
+            total += put[p];
+            for (i = 0; i < MAXITEM; ++i) {
+                if (i < put[p] && got[p*MAXITEM + i] == 0)
+                    lost++;
+                else if (got[p*MAXITEM + i] > (i < put[p]))
+                    dup++;
+            }
+        }
+        bbuf_destroy(&queue);
+    }
+    printf("%s,%d,%ld,%ld,%ld,%ld,%s\n", name, rounds, total, atomic_load(&phantom), dup, lost,
+           atomic_load(&phantom) + dup + lost == 0 ? "ok" : "FAIL");
+    return atomic_load(&phantom) + dup + lost == 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q cas|sem|spin|fast|all] [-p producers] [-c consumers] [-r rounds]\n", prog);
+    exit(-1);
+}
+
+/*
+ * 메인 함수는 방식마다 검사하여 CSV 한 줄씩 출력한다.
+ * 잃어버리거나 두 번 나오거나 넣지 않은 아이템이 하나라도 있으면 1을 리턴하고, 소비자가 깨어나지 못하면
+ * 바로 1로 끝난다.
+ */
+int main(int argc, char *argv[])
+{
+    static const char *name[] = {"cas", "sem", "spin", "fast"};
+    int opt, type = -1, rounds = NROUND;
+    bool ok = true;
+
+    while ((opt = getopt(argc, argv, "q:p:c:r:")) != -1) {
+        switch (opt) {
+            case 'q':
+                if (strcmp(optarg, "all") == 0) {
+                    type = -1;
+                    break;
+                }
+                for (type = BBUF_CAS; type <= BBUF_FAST && strcmp(optarg, name[type]) != 0; ++type)
+                    ;
+                if (type > BBUF_FAST)
+                    usage(argv[0]);
+                break;
+            case 'p':
+                np = atoi(optarg);
+                break;
+            case 'c':
+                nc = atoi(optarg);
+                break;
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (np <= 0 || np > NPRODUCER || nc <= 0 || rounds <= 0)
+        usage(argv[0]);
+    printf("type,rounds,put,phantom,duplicate,lost,result\n");
+    if (type >= 0)
+        ok = check(name[type], type, rounds);
+    else
+        for (type = BBUF_CAS; type <= BBUF_FAST; ++type)
+            ok = check(name[type], type, rounds) && ok;
+    return ok ? 0 : 1;
+}
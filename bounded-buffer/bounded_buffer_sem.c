@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <unistd.h>
 #include <semaphore.h>
 #include <pthread.h>
@@ -22,8 +23,9 @@ int in = 0;
 int out = 0;
 /*
  * 생산된 아이템과 소비된 아이템의 개수를 기록하기 위한 변수이다.
+ * produced는 소비자가 남은 아이템이 있는지 판단할 때 생산자와 다른 뮤텍스를 잡고 읽으므로 원자 변수로 둔다.
  */
-int produced = 0;
+atomic_int produced = 0;
 int consumed = 0;
 /*
  * 네 개의 세마포를 필요에 따라 생산자와 소비자가 공유한다.
@@ -37,9 +39,10 @@ sem_t empty, full, pro_mutex, con_mutex;
 error "Unknown compiler"
 #endif
 /*
- * alive 값이 false가 될 때까지 스레드 내의 루프가 무한히 반복된다.
+ * closed 값이 true가 되면 버퍼가 닫힌다. 생산자는 더 이상 아이템을 넣지 않고 끝나며,
+ * 소비자는 버퍼에 남은 아이템을 모두 꺼낸 다음 끝난다.
  */
-bool alive = true;
+atomic_bool closed = false;
 
 /*
  * 생산자 스레드로 실행할 함수이다. 아이템(난수)을 생성하여 버퍼에 넣는다.
@@ -49,15 +52,24 @@ void *producer(void *arg)
     int i = *(int *)arg;
     int item;
     
-    while (alive) {
+    while (true) {
         /*
-         * 버퍼에 빈 공간을 기다린 다음 임계구역에 들어가기 위해 뮤텍스락을 기다린다.
+         * 버퍼에 빈 공간을 기다린다. 깨어났을 때 버퍼가 닫혀 있으면 받은 빈 공간을 돌려주고 끝난다.
+         * 돌려준 값으로 빈 공간을 기다리던 다음 생산자가 깨어나므로 모든 생산자가 차례로 끝난다.
          */
 #ifdef __APPLE__
         sem_wait(empty);
+        if (closed) {
+            sem_post(empty);
+            break;
+        }
         sem_wait(pro_mutex);
 #elif __linux__ | __unix__
         sem_wait(&empty);
+        if (closed) {
+            sem_post(&empty);
+            break;
+        }
         sem_wait(&pro_mutex);
 #else
 error "Unknown compiler"
@@ -97,16 +109,29 @@ void *consumer(void *arg)
     int i = *(int *)arg;
     int item;
      
-    while (alive) {
+    while (true) {
         /*
          * 새 아이템이 버퍼에 채워지기를 기다린 다음 임계구역에 들어가기 위해 뮤텍스락을 기다린다.
+         * 버퍼가 닫히면 메인 스레드가 아이템 없이 full을 하나 올려준다. 임계구역에서 보니 남은 아이템이
+         * 없으면 그 값을 다른 소비자에게 넘겨주고 끝난다. 생산자가 모두 끝난 뒤에 올려주므로
+         * 그 다음에는 produced가 변하지 않는다.
          */
 #ifdef __APPLE__
         sem_wait(full);
         sem_wait(con_mutex);
+        if (consumed == produced) {
+            sem_post(con_mutex);
+            sem_post(full);
+            break;
+        }
 #elif __linux__ | __unix__
         sem_wait(&full);
         sem_wait(&con_mutex);
+        if (consumed == produced) {
+            sem_post(&con_mutex);
+            sem_post(&full);
+            break;
+        }
 #else
 error "Unknown compiler"
 #endif
@@ -183,20 +208,32 @@ error "Unknown compiler"
      */
     usleep(1000);
     /*
-     * 스레드가 자연스럽게 무한 루프를 빠져나올 수 있게 한다.
+     * 버퍼를 닫는다. 세마포를 기다리는 스레드를 철회(pthread_cancel)하면 뮤텍스 세마포를 잡은 채로
+     * 끝나거나 버퍼에 든 아이템을 잃을 수 있으므로, 세마포 값을 올려서 스레드가 스스로 끝나게 한다.
+     * 먼저 빈 공간을 하나 올려서 기다리는 생산자를 깨우고, 생산자가 모두 끝날 때까지 기다린다.
      */
-    alive = false;
-    /*
-     * while 루프의 조건이 false로 변경되어도 세마포를 기다리는 스레드가 있을 수 있다.
-     * 다른 스레드가 종료되서 세마포 값을 증가시키지 못하면 그 스레드는 교착상태에 빠진다.
-     * 이런 경우를 고려하여 모든 스레드를 강제로 철회한다.
-     */
-    for (i = 0; i < N; ++i)
-        pthread_cancel(tid[i]);    
+    closed = true;
+#ifdef __APPLE__
+    sem_post(empty);
+#elif __linux__ | __unix__
+    sem_post(&empty);
+#else
+error "Unknown compiler"
+#endif
+    for (i = N/2; i < N; ++i)
+        pthread_join(tid[i], NULL);
     /*
-     * 자식 스레드가 종료될 때까지 기다린다.
+     * 이제 생산된 아이템의 개수가 확정되었다. full을 하나 올려서 소비자가 남은 아이템을 모두 꺼내고
+     * 끝나게 한 다음, 소비자가 모두 끝날 때까지 기다린다.
      */
-    for (i = 0; i < N; ++i)
+#ifdef __APPLE__
+    sem_post(full);
+#elif __linux__ | __unix__
+    sem_post(&full);
+#else
+error "Unknown compiler"
+#endif
+    for (i = 0; i < N/2; ++i)
         pthread_join(tid[i], NULL);
     /*
      * 모든 세마포를 지운다.
@@ -217,7 +254,7 @@ error "Unknown compiler"
     /*
      * 생산된 아이템의 개수와 소비된 아이템의 개수를 출력한다.
      */
-    printf("Total %d items were produced.\n", produced);
+    printf("Total %d items were produced.\n", atomic_load(&produced));
     printf("Total %d items were consumed.\n", consumed);
     /*
      * 메인함수를 종료한다.
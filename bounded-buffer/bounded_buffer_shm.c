@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "shm_ring.h"
+
+#define RINGSIZE (1 << 20)
+#define CHUNK 65536
+#define TOTAL (1L << 30)
+
+/*
+ * 생산자 프로세스는 TOTAL 바이트를 CHUNK 바이트씩 공유 원형 버퍼에 쓴다.
+ * 바이트 k의 값은 k % 251로, 소비자가 순서와 내용을 확인할 수 있다.
+ * crash가 0이 아니면 절반쯤 쓰고 비정상 종료하여 소비자가 이를 감지하는지 확인한다.
+ */
+static int producer(shm_ring_t *ring, int crash)
+{
+    static uint8_t chunk[CHUNK];
+    long sent = 0;
+
+    if (shm_ring_attach(ring, SHM_PRODUCER) != SHM_SUCCESS)
+        return -1;
+    while (sent < TOTAL) {
+        for (int k = 0; k < CHUNK; ++k)
+            chunk[k] = (uint8_t)((sent + k) % 251);
+        if (shm_ring_write(ring, chunk, CHUNK) != SHM_SUCCESS) {
+            fprintf(stderr, "producer: consumer is gone\n");
+            return -1;
+        }
+        sent += CHUNK;
+        if (crash && sent >= TOTAL / 2)
+            abort();
+    }
+    shm_ring_detach(ring);
+    return 0;
+}
+
+/*
+ * 소비자 프로세스는 버퍼가 닫히거나 생산자가 죽을 때까지 읽으면서 내용을 검사한다.
+ */
+static int consumer(shm_ring_t *ring)
+{
+    static uint8_t buf[CHUNK];
+    struct timespec start, end;
+    long received = 0, bad = 0;
+    size_t len;
+    int rc;
+    double sec;
+
+    if (shm_ring_attach(ring, SHM_CONSUMER) != SHM_SUCCESS)
+        return -1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((rc = shm_ring_read(ring, buf, sizeof(buf), &len)) == SHM_SUCCESS) {
+        for (size_t k = 0; k < len; ++k)
+            if (buf[k] != (uint8_t)((received + k) % 251))
+                bad++;
+        received += len;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Total %ld bytes were received (%.1f MB/s), %ld bytes were wrong.\n",
+           received, received / sec / 1e6, bad);
+    printf(rc == SHM_CLOSED ? "Producer closed the ring.\n" : "Producer died.\n");
+    shm_ring_detach(ring);
+    return 0;
+}
+
+/*
+ * 메인 함수는 공유 원형 버퍼를 만들고 fork()하여 부모는 생산자, 자식은 소비자가 된다.
+ * 인자로 crash를 주면 생산자가 중간에 비정상 종료한다.
+ */
+int main(int argc, char *argv[])
+{
+    shm_ring_t ring;
+    pid_t pid;
+    int crash = argc > 1 && strcmp(argv[1], "crash") == 0;
+
+    if (shm_ring_create(&ring, RINGSIZE) != SHM_SUCCESS) {
+        fprintf(stderr, "shm_ring_create error\n");
+        exit(-1);
+    }
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "fork error\n");
+        exit(-1);
+    }
+    if (pid == 0) {
+        consumer(&ring);
+        shm_ring_close(&ring);
+        exit(0);
+    }
+    if (crash) {
+        /*
+         * 비정상 종료를 흉내낼 생산자도 별도의 프로세스로 만든다.
+         */
+        if (fork() == 0)
+            exit(producer(&ring, crash));
+        wait(NULL);
+    }
+    else
+        producer(&ring, 0);
+    waitpid(pid, NULL, 0);
+    shm_ring_close(&ring);
+    return 0;
+}
@@ -3,86 +3,91 @@
  * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <stdatomic.h>
 #include <pthread.h>
+#include "spinlock.h"
 
 #define N 8
+#define NCOLOR 8
 /*
  * ANSI 컬러 코드: 출력을 쉽게 구분하기 위해서 사용한다.
  * 순서대로 BLK, RED, GRN, YEL, BLU, MAG, CYN, WHT, RESET을 의미한다.
  */
-char *color[N+1] = {"\e[0;30m","\e[0;31m","\e[0;32m","\e[0;33m","\e[0;34m","\e[0;35m","\e[0;36m","\e[0;37m","\e[0m"};
+char *color[NCOLOR+1] = {"\e[0;30m","\e[0;31m","\e[0;32m","\e[0;33m","\e[0;34m","\e[0;35m","\e[0;36m","\e[0;37m","\e[0m"};
 /*
- * 스핀락으로 사용할 원자변수 lock은 모든 스레드가 공유한다.
- * waiting[i]는 스레드 i가 임계구역에 들어가기 위해 기다리고 있음을 나타낸다.
+ * MCS 큐 락 lock은 모든 스레드가 공유한다.
+ * 기다리는 스레드는 도착한 순서대로 대기열에 줄을 서고, 락을 푸는 스레드가 바로 뒤의 스레드에게
+ * 락을 직접 넘겨준다. 따라서 n 개의 스레드가 있으면 앞에 기껏해야 n-1 개의 스레드만 있으므로
+ * waiting[] 배열을 훑지 않고도 한정된 대기(bounded waiting)가 보장된다.
+ * 각 스레드는 자기 캐시라인에 있는 노드만 보면서 돌기 때문에 다른 스레드를 방해하지 않는다.
  * alive 값이 false가 될 때까지 스레드 내의 루프가 무한히 반복된다.
  */
-atomic_bool lock = false;
-bool waiting[N];
-bool alive = true;
+spinlock_t lock;
+atomic_bool alive = true;
 
 /*
- * N 개의 스레드가 임계구역에 배타적으로 들어가기 위해 스핀락을 사용하여 동기화한다.
+ * n 개의 스레드가 임계구역에 배타적으로 들어가기 위해 MCS 큐 락을 사용하여 동기화한다.
  */
 void *worker(void *arg)
 {
     int i = *(int *)arg;
-    int j;
-    bool expected, blocked;
-    
+    spin_node_t node;
+
+    /*
+     * 대기열에 넣을 자신의 노드를 준비한다.
+     */
+    if (spin_node_init(&node) != SPIN_SUCCESS)
+        pthread_exit(NULL);
     while (alive) {
-        waiting[i] = blocked = true;
-        expected = false;
         /*
-         * 대기상태이고 임계구역이 차단되어 있으면 계속 돈다.
+         * 대기열 끝에 줄을 서고, 앞선 스레드가 락을 넘겨줄 때까지 자기 노드만 보면서 기다린다.
          */
-        while (waiting[i] && blocked)
-            if (atomic_compare_exchange_strong(&lock, &expected, true))
-                blocked = false;
-            else
-                expected = false;
-        /*
-         * 임계구역에 들어왔으므로 더이상 기다리는 상태가 아니다.
-         */
-        waiting[i] = false;
+        spin_lock(&lock, &node);
         /*
          * 임계구역: 알파벳 문자를 한 줄에 40개씩 10줄 출력한다.
          */
         for (int k = 0; k < 400; ++k) {
-            printf("%s%c%s", color[i], 'A'+i, color[N]);
+            printf("%s%c%s", color[i % NCOLOR], 'A'+i%26, color[NCOLOR]);
             if ((k+1) % 40 == 0)
                 printf("\n");
         }
         /*
          * 임계구역이 성공적으로 종료되었다.
-         * 락을 풀지 않고 임계구역을 기다리는 다음 스레드 j를 찾는다.
+         * 기다리는 스레드가 있으면 대기열의 바로 다음 스레드에게 O(1)에 락을 넘겨주고,
+         * 없으면 락을 푼다.
          */
-        j = (i+1) % N;
-        while (j != i && !waiting[j])
-            j = (j+1) % N;
-        /*
-         * 다음 대상 스레드가 자신이면 더 이상 기다리는 스레드가 없으므로 락을 푼다.
-         * 그렇지 않으면 락을 건 상태로 j가 임계구역에 들어갈 수 있도록 한다.
-         */
-        if (j == i)
-            lock = false;
-        else
-            waiting[j] = false;
+        spin_unlock(&lock, &node);
     }
+    spin_node_destroy(&node);
     pthread_exit(NULL);
 }
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    pthread_t tid[N];
-    int i, id[N];
+    pthread_t *tid;
+    int i, n, *id;
 
     /*
-     * N 개의 자식 스레드를 생성한다.
+     * 스레드의 수는 실행할 때 인자로 받는다. 인자가 없으면 N 개를 만든다.
+     */
+    n = argc > 1 ? atoi(argv[1]) : N;
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [nthreads]\n", argv[0]);
+        exit(-1);
+    }
+    tid = (pthread_t *)malloc(sizeof(pthread_t)*n);
+    id = (int *)malloc(sizeof(int)*n);
+    if (tid == NULL || id == NULL || spinlock_init(&lock, SPIN_MCS) != SPIN_SUCCESS) {
+        fprintf(stderr, "initialization error\n");
+        exit(-1);
+    }
+    /*
+     * n 개의 자식 스레드를 생성한다.
      */
-    for (i = 0; i < N; ++i) {
+    for (i = 0; i < n; ++i) {
         id[i] = i;
         pthread_create(tid+i, NULL, worker, id+i);
     }
@@ -98,10 +103,13 @@ int main(void)
     /*
      * 자식 스레드가 종료될 때까지 기다린다.
      */
-    for (i = 0; i < N; ++i)
+    for (i = 0; i < n; ++i)
         pthread_join(tid[i], NULL);
     /*
-     * 메인함수를 종료한다.
+     * 락과 배열을 반납하고 메인함수를 종료한다.
      */
+    spinlock_destroy(&lock);
+    free(tid);
+    free(id);
     return 0;
 }
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "record_ring.h"
+
+#define N 8
+#define RINGSIZE (1 << 20)
+#define MINREC 4096
+#define MAXREC 65536
+/*
+ * 생산자와 소비자가 공유할 바이트 원형 버퍼
+ */
+rring_t ring;
+/*
+ * 생산된 레코드와 소비된 레코드의 개수와 바이트 수, 내용이 깨진 레코드의 개수를 기록하기 위한 변수
+ */
+atomic_long produced = 0;
+atomic_long consumed = 0;
+atomic_long bytes = 0;
+atomic_long corrupted = 0;
+/*
+ * alive 값이 false가 될 때까지 생산자 스레드 내의 루프가 무한히 반복된다.
+ */
+atomic_bool alive = true;
+
+/*
+ * 생산자 스레드로 실행할 함수이다. 4KB에서 64KB 사이의 레코드를 버퍼 안에 직접 쓴다.
+ * 레코드의 첫 8바이트는 나머지 내용에서 계산한 검사합이다.
+ */
+void *producer(void *arg)
+{
+    unsigned seed = (unsigned)time(NULL) ^ (unsigned)(*(int *)arg * 7919);
+    uint64_t *rec, sum;
+    size_t len, n;
+
+    while (alive) {
+        len = (MINREC + rand_r(&seed) % (MAXREC - MINREC + 1)) & ~(size_t)7;
+        n = len / sizeof(uint64_t);
+        /*
+         * 버퍼 안에 레코드 자리를 예약하고, 복사하지 않고 그 자리에 바로 쓴 다음 발행한다.
+         */
+        rec = rring_reserve(&ring, len);
+        sum = 0;
+        for (size_t k = 1; k < n; ++k) {
+            rec[k] = ((uint64_t)rand_r(&seed) << 32) | k;
+            sum += rec[k];
+        }
+        rec[0] = sum;
+        rring_commit(&ring, rec, len);
+        atomic_fetch_add(&produced, 1);
+    }
+    pthread_exit(NULL);
+}
+
+/*
+ * 소비자 스레드로 실행할 함수이다. 레코드를 버퍼 안에서 그대로 검사한 다음 공간을 돌려준다.
+ * 길이가 0인 레코드는 종료 신호이다.
+ */
+void *consumer(void *arg)
+{
+    uint64_t *rec, sum;
+    size_t len, n;
+
+    (void)arg;
+    while (true) {
+        rec = rring_peek(&ring, &len);
+        if (len == 0) {
+            rring_release(&ring, rec);
+            break;
+        }
+        n = len / sizeof(uint64_t);
+        sum = 0;
+        for (size_t k = 1; k < n; ++k)
+            sum += rec[k];
+        if (sum != rec[0])
+            atomic_fetch_add(&corrupted, 1);
+        rring_release(&ring, rec);
+        atomic_fetch_add(&consumed, 1);
+        atomic_fetch_add(&bytes, (long)len);
+    }
+    pthread_exit(NULL);
+}
+
+int main(void)
+{
+    pthread_t tid[N];
+    int i, id[N];
+    void *rec;
+    struct timespec start, end;
+    double sec;
+
+    if (rring_init(&ring, RINGSIZE) != RRING_SUCCESS) {
+        fprintf(stderr, "rring_init error\n");
+        exit(-1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    /*
+     * N/2 개의 소비자 스레드와 N/2 개의 생산자 스레드를 생성한다.
+     */
+    for (i = 0; i < N; ++i) {
+        id[i] = i;
+        pthread_create(tid+i, NULL, i < N/2 ? consumer : producer, id+i);
+    }
+    /*
+     * 스레드가 일하는 동안 1초 쉰 다음, 생산자를 먼저 끝낸다.
+     */
+    sleep(1);
+    alive = false;
+    for (i = N/2; i < N; ++i)
+        pthread_join(tid[i], NULL);
+    /*
+     * 소비자마다 길이가 0인 레코드를 하나씩 넣어서 남은 레코드를 모두 처리하고 끝나게 한다.
+     */
+    for (i = 0; i < N/2; ++i) {
+        rec = rring_reserve(&ring, 0);
+        rring_commit(&ring, rec, 0);
+    }
+    for (i = 0; i < N/2; ++i)
+        pthread_join(tid[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    rring_destroy(&ring);
+    /*
+     * 생산된 레코드와 소비된 레코드의 개수, 처리량과 깨진 레코드의 개수를 출력한다.
+     */
+    printf("Total %ld records were produced.\n", produced);
+    printf("Total %ld records were consumed (%.1f MB/s).\n", consumed, bytes / sec / 1e6);
+    printf("Total %ld records were corrupted.\n", corrupted);
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdlib.h>
+#include <limits.h>
+#include "broadcast_ring.h"
+#include "futex.h"
+
+/*
+ * 방송 원형 버퍼를 size 개의 자리로 초기화한다. size는 2 이상인 2의 거듭제곱이어야 한다.
+ * 성공하면 BRING_SUCCESS를, 실패하면 BRING_FAIL을 리턴한다.
+ */
+int bring_init(bring_t *r, size_t size)
+{
+    if (size < 2 || (size & (size - 1)) != 0)
+        return BRING_FAIL;
+    r->slot = (int *)aligned_alloc(SPIN_CACHELINE,
+                                   (sizeof(int)*size + SPIN_CACHELINE - 1) & ~(size_t)(SPIN_CACHELINE - 1));
+    r->avail = (_Atomic uint64_t *)aligned_alloc(SPIN_CACHELINE, sizeof(uint64_t)*size < SPIN_CACHELINE ?
+                                                 SPIN_CACHELINE : sizeof(uint64_t)*size);
+    if (r->slot == NULL || r->avail == NULL) {
+        free(r->slot);
+        free(r->avail);
+        return BRING_FAIL;
+    }
+    for (size_t k = 0; k < size; ++k)
+        atomic_init(&r->avail[k], 0);
+    r->size = size;
+    r->mask = size - 1;
+    r->nconsumer = 0;
+    atomic_init(&r->claim, 0);
+    atomic_init(&r->gate, 0);
+    atomic_init(&r->nrel, 0);
+    atomic_init(&r->rwaiting, 0);
+    atomic_init(&r->npub, 0);
+    atomic_init(&r->cwaiting, 0);
+    return BRING_SUCCESS;
+}
+
+/*
+ * 방송 원형 버퍼에 할당된 자원을 반납한다. 버퍼를 사용하는 스레드가 없어야 한다.
+ */
+void bring_destroy(bring_t *r)
+{
+    free(r->slot);
+    free(r->avail);
+    r->slot = NULL;
+    r->avail = NULL;
+}
+
+/*
+ * 소비자를 등록하고 그 번호를 리턴한다. deps에 있는 ndeps 개의 소비자가 처리한 아이템만 보게 되므로
+ * 소비자를 단계별로 이어서 파이프라인을 만들 수 있다. deps는 이미 등록된 소비자여야 한다.
+ * 생산자나 소비자가 버퍼를 사용하기 전에 등록해야 하며, 실패하면 -1을 리턴한다.
+ */
+int bring_add_consumer(bring_t *r, const int *deps, int ndeps)
+{
+    bring_cursor_t *c;
+    int id = r->nconsumer;
+
+    if (id >= BRING_MAXCONSUMER || ndeps < 0 || ndeps > BRING_MAXCONSUMER)
+        return -1;
+    for (int k = 0; k < ndeps; ++k)
+        if (deps[k] < 0 || deps[k] >= id)
+            return -1;
+    c = &r->cursor[id];
+    atomic_init(&c->seq, atomic_load(&r->claim));
+    c->ndeps = ndeps;
+    c->gating = true;
+    for (int k = 0; k < ndeps; ++k) {
+        c->deps[k] = deps[k];
+        /*
+         * 앞 단계 소비자는 이 소비자보다 항상 앞서 있으므로 생산자가 볼 필요가 없다.
+         */
+        r->cursor[deps[k]].gating = false;
+    }
+    r->nconsumer = id + 1;
+    return id;
+}
+
+/*
+ * 생산자를 막고 있는 가장 느린 소비자의 커서를 구한다. 소비자가 없으면 생산자를 막지 않는다.
+ */
+static uint64_t slowest(bring_t *r, uint64_t limit)
+{
+    uint64_t s;
+
+    for (int i = 0; i < r->nconsumer; ++i) {
+        if (!r->cursor[i].gating)
+            continue;
+        s = atomic_load_explicit(&r->cursor[i].seq, memory_order_acquire);
+        if (s < limit)
+            limit = s;
+    }
+    return limit;
+}
+
+/*
+ * 생산자: 아이템 하나를 쓸 번호를 받아 *seq에 저장하고, 그 자리의 주소를 리턴한다.
+ * 가장 느린 소비자가 그 자리의 이전 아이템을 다 읽을 때까지 기다린다.
+ * gate는 커서를 acquire로 읽은 생산자가 release로 저장하므로, gate만 보고 지나가도
+ * 소비자가 다 읽은 자리에만 쓰게 된다.
+ * 생산자는 리턴된 자리에 아이템을 쓴 다음 bring_publish()를 불러야 한다.
+ */
+int *bring_claim(bring_t *r, uint64_t *seq)
+{
+    uint64_t t = atomic_fetch_add_explicit(&r->claim, 1, memory_order_relaxed);
+    uint64_t gate;
+    int seen;
+
+    while (t - atomic_load_explicit(&r->gate, memory_order_acquire) >= r->size) {
+        /*
+         * 저장해 둔 커서로는 여유가 없으므로 모든 커서를 다시 읽는다.
+         */
+        seen = atomic_load(&r->nrel);
+        gate = slowest(r, t);
+        atomic_store_explicit(&r->gate, gate, memory_order_release);
+        if (t - gate < r->size)
+            break;
+        futex_park(&r->nrel, seen, &r->rwaiting);
+    }
+    *seq = t;
+    return &r->slot[t & r->mask];
+}
+
+/*
+ * 생산자: bring_claim()으로 받은 번호 seq의 아이템을 발행한다.
+ * 자리마다 발행 표시를 하므로 앞 번호를 받은 생산자가 발행하기를 기다리지 않는다.
+ * 앞 번호를 받은 생산자가 선점당해도 다른 생산자는 계속 발행할 수 있고,
+ * 소비자만 그 번호에서 멈춰 기다린다.
+ */
+void bring_publish(bring_t *r, uint64_t seq)
+{
+    atomic_store_explicit(&r->avail[seq & r->mask], seq + 1, memory_order_release);
+    atomic_fetch_add(&r->npub, 1);
+    if (atomic_load(&r->cwaiting) > 0)
+        futex_wake(&r->npub, INT_MAX);
+}
+
+/*
+ * 소비자가 next부터 읽을 수 있는 번호의 끝을 구한다. 앞 단계 소비자가 있으면 그 커서 중 가장 작은 값이고,
+ * 없으면 next부터 발행 표시가 끊기지 않고 이어지는 데까지이다. 어느 쪽이든 end를 넘지 않는다.
+ * 앞 단계 소비자는 발행된 아이템만 처리하므로 그 커서까지는 모두 발행된 것이다.
+ */
+static uint64_t readable(bring_t *r, bring_cursor_t *c, uint64_t next, uint64_t end)
+{
+    uint64_t limit = end, s;
+
+    if (c->ndeps > 0) {
+        for (int k = 0; k < c->ndeps; ++k) {
+            s = atomic_load_explicit(&r->cursor[c->deps[k]].seq, memory_order_acquire);
+            if (s < limit)
+                limit = s;
+        }
+        return limit;
+    }
+    for (s = next; s < limit; ++s)
+        if (atomic_load_explicit(&r->avail[s & r->mask], memory_order_acquire) != s + 1)
+            break;
+    return s;
+}
+
+/*
+ * 소비자 id: 읽을 아이템이 생길 때까지 기다린 다음, 버퍼 안에 연속으로 놓인 아이템의 주소를 리턴하고
+ * 그 개수를 *n에 저장한다. 버퍼 끝을 넘어가는 아이템은 다음 호출에서 돌려준다.
+ * 소비자는 아이템을 그 자리에서 처리한 다음 bring_release()로 처리한 개수를 알려야 한다.
+ * 앞 단계 소비자가 있으면 커서가 옮겨지기를 기다리고, 없으면 발행을 기다린다.
+ */
+const int *bring_peek(bring_t *r, int id, size_t *n)
+{
+    bring_cursor_t *c = &r->cursor[id];
+    uint64_t next = atomic_load_explicit(&c->seq, memory_order_relaxed), limit;
+    size_t off = next & r->mask;
+    int seen;
+
+    while (true) {
+        seen = c->ndeps > 0 ? atomic_load(&r->nrel) : atomic_load(&r->npub);
+        limit = readable(r, c, next, next + (r->size - off));
+        if (limit != next)
+            break;
+        if (c->ndeps > 0)
+            futex_park(&r->nrel, seen, &r->rwaiting);
+        else
+            futex_park(&r->npub, seen, &r->cwaiting);
+    }
+    *n = limit - next;
+    return &r->slot[off];
+}
+
+/*
+ * 소비자 id: bring_peek()로 받은 아이템 중 앞에서부터 n개의 처리를 끝내고 커서를 옮긴다.
+ * 그 자리를 기다리는 생산자와 이 소비자에게 의존하는 소비자를 깨운다.
+ */
+void bring_release(bring_t *r, int id, size_t n)
+{
+    bring_cursor_t *c = &r->cursor[id];
+
+    atomic_store_explicit(&c->seq, atomic_load_explicit(&c->seq, memory_order_relaxed) + n,
+                          memory_order_release);
+    atomic_fetch_add(&r->nrel, 1);
+    if (atomic_load(&r->rwaiting) > 0)
+        futex_wake(&r->nrel, INT_MAX);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef BROADCAST_RING_H
+#define BROADCAST_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "spinlock.h"
+
+#define BRING_MAXCONSUMER 16
+#define BRING_SUCCESS 0
+#define BRING_FAIL 4
+
+/*
+ * 소비자마다 하나씩 가지는 커서 구조체 타입
+ *
+ * seq는 이 소비자가 처리를 끝낸 다음 번호로, 이 소비자만 쓰고 생산자와 뒤 단계 소비자가 읽는다.
+ * 커서마다 캐시라인 하나를 혼자 차지하므로 소비자가 서로의 캐시라인을 건드리지 않는다.
+ * deps는 이 소비자보다 먼저 처리해야 하는 소비자의 번호이다. 이 소비자는 deps의 커서를 넘지 않는다.
+ * gating은 이 소비자에게 의존하는 소비자가 없으면 true로, 생산자는 이런 소비자의 커서만 본다.
+ */
+typedef struct {
+    _Alignas(SPIN_CACHELINE) _Atomic uint64_t seq;  /* 처리를 끝낸 다음 번호 */
+    int ndeps;                                      /* 먼저 처리해야 하는 소비자의 수 */
+    int deps[BRING_MAXCONSUMER];                    /* 먼저 처리해야 하는 소비자의 번호 */
+    bool gating;                                    /* 생산자가 이 커서를 넘지 않아야 하면 true */
+} bring_cursor_t;
+
+/*
+ * 모든 소비자가 모든 아이템을 보는 방송(broadcast) 원형 버퍼 구조체 타입
+ *
+ * 아이템은 0부터 차례로 번호를 받고, 번호 seq의 아이템은 slot[seq & mask]에 놓인다.
+ * 생산자는 claim에서 번호를 받아 그 자리에 직접 쓴 다음, 같은 위치의 avail에 seq + 1을 써서 발행한다.
+ * 생산자는 서로의 발행을 기다리지 않으며, 소비자는 자기 커서부터 avail이 이어지는 데까지
+ * (그리고 앞 단계 소비자의 커서까지) 버퍼 안에서 그대로 읽은 다음 커서를 옮긴다.
+ * 락도 없고 아이템을 복사하지도 않는다.
+ * 생산자는 가장 느린 소비자의 커서보다 size 이상 앞서지 못한다. gate는 마지막으로 구한
+ * 가장 느린 커서로, 여유가 있는 동안에는 모든 커서를 다시 읽지 않는다.
+ * npub은 발행 횟수, nrel은 소비자가 커서를 옮긴 횟수로 기다리는 스레드가 잠드는 futex 변수이다.
+ */
+typedef struct {
+    int *slot;                                          /* 아이템을 저장할 배열 */
+    _Atomic uint64_t *avail;                            /* 자리마다 발행된 번호 + 1 */
+    size_t size;                                        /* 배열의 크기 (2의 거듭제곱) */
+    uint64_t mask;                                      /* size - 1 */
+    int nconsumer;                                      /* 등록된 소비자의 수 */
+    _Alignas(SPIN_CACHELINE) _Atomic uint64_t claim;    /* 생산자에게 줄 다음 번호 */
+    _Atomic uint64_t gate;                              /* 마지막으로 구한 가장 느린 커서 */
+    atomic_int nrel;                                    /* 커서를 옮긴 횟수 (futex) */
+    atomic_int rwaiting;                                /* 커서가 옮겨지기를 기다리며 잠든 스레드의 수 */
+    _Alignas(SPIN_CACHELINE) atomic_int npub;           /* 발행 횟수 (futex) */
+    atomic_int cwaiting;                                /* 발행을 기다리며 잠든 소비자의 수 */
+    bring_cursor_t cursor[BRING_MAXCONSUMER];           /* 소비자의 커서 */
+} bring_t;
+
+int bring_init(bring_t *r, size_t size);
+void bring_destroy(bring_t *r);
+int bring_add_consumer(bring_t *r, const int *deps, int ndeps);
+int *bring_claim(bring_t *r, uint64_t *seq);
+void bring_publish(bring_t *r, uint64_t seq);
+const int *bring_peek(bring_t *r, int id, size_t *n);
+void bring_release(bring_t *r, int id, size_t n);
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "spinlock.h"
+
+#define FUTEX_SPINCOUNT 128
+
+/*
+ * *addr 값이 아직 val이면 다른 스레드가 깨울 때까지 잠든다.
+ * 잠들기 전에 값이 바뀌었으면 즉시 리턴하므로 깨우는 신호를 놓치지 않는다.
+ */
+static inline void futex_wait(atomic_int *addr, int val)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+/*
+ * addr에서 잠들어 있는 스레드를 최대 n개 깨운다.
+ */
+static inline void futex_wake(atomic_int *addr, int n)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/*
+ * seq 값이 seen에서 바뀌기를 기다린다. 먼저 FUTEX_SPINCOUNT 번 짧게 돌아본 다음,
+ * 그래도 바뀌지 않으면 waiting을 증가시키고 futex에서 잠든다.
+ * 깨우는 쪽은 seq를 바꾼 다음 waiting이 0보다 클 때만 futex_wake()를 부르면 된다.
+ * 잠들기 전에 돌아본 횟수를 리턴한다.
+ */
+static inline int futex_park(atomic_int *seq, int seen, atomic_int *waiting)
+{
+    for (int k = 0; k < FUTEX_SPINCOUNT; ++k) {
+        if (atomic_load_explicit(seq, memory_order_relaxed) != seen)
+            return k;
+        cpu_relax();
+    }
+    atomic_fetch_add(waiting, 1);
+    futex_wait(seq, seen);
+    atomic_fetch_sub(waiting, 1);
+    return FUTEX_SPINCOUNT;
+}
+
+/*
+ * 기다리는 쪽의 통계: 기다리며 돈 횟수와 실패한 원자적 비교 교환(CAS)의 횟수
+ * 한 스레드만 사용하는 지역 변수로 두고, 필요하면 호출한 쪽이 모아서 보고한다.
+ */
+typedef struct {
+    unsigned long spins;    /* 기다리며 돈 횟수 */
+    unsigned long fails;    /* 실패한 CAS의 횟수 */
+} futex_stat_t;
+
+/*
+ * futex로 만든 세마포 구조체 타입
+ *
+ * count는 세마포 값이고, waiters는 count가 0이라서 잠든 스레드의 수이다.
+ * 값이 남아 있으면 원자적 연산 한 번으로 끝나고, 0일 때만 커널에 들어가서 잠든다.
+ * 값을 올릴 때도 잠든 스레드가 있을 때만 커널에 들어가서 깨운다.
+ */
+typedef struct {
+    atomic_int count;       /* 세마포 값 (futex) */
+    atomic_int waiters;     /* 잠든 스레드의 수 */
+} fsem_t;
+
+static inline void fsem_init(fsem_t *s, int value)
+{
+    atomic_init(&s->count, value);
+    atomic_init(&s->waiters, 0);
+}
+
+/*
+ * 세마포 값이 1 이상이 될 때까지 기다린 다음 1을 뺀다.
+ */
+static inline void fsem_wait(fsem_t *s)
+{
+    int c = atomic_load_explicit(&s->count, memory_order_relaxed);
+
+    while (true) {
+        if (c > 0) {
+            if (atomic_compare_exchange_weak_explicit(&s->count, &c, c - 1,
+                                                      memory_order_acquire, memory_order_relaxed))
+                return;
+            continue;
+        }
+        futex_park(&s->count, 0, &s->waiters);
+        c = atomic_load_explicit(&s->count, memory_order_relaxed);
+    }
+}
+
+/*
+ * 세마포 값이 남아 있으면 최대 n까지 있는 만큼 한 번에 빼고 뺀 값을 리턴한다.
+ * 값이 0이면 기다리지 않고 0을 리턴한다. st가 NULL이 아니면 실패한 CAS를 센다.
+ */
+static inline int fsem_trywait_n(fsem_t *s, int n, futex_stat_t *st)
+{
+    int c = atomic_load_explicit(&s->count, memory_order_relaxed);
+    int m;
+
+    while (c > 0) {
+        m = c < n ? c : n;
+        if (atomic_compare_exchange_weak_explicit(&s->count, &c, c - m,
+                                                  memory_order_acquire, memory_order_relaxed))
+            return m;
+        if (st != NULL)
+            st->fails++;
+    }
+    return 0;
+}
+
+/*
+ * 세마포 값이 1 이상이 될 때까지 기다린 다음, 최대 n까지 있는 만큼 한 번에 빼고 뺀 값을 리턴한다.
+ * 여러 자리를 한 번의 원자적 연산으로 얻으며, n개가 모두 생길 때까지 기다리지는 않는다.
+ * st가 NULL이 아니면 기다리며 돈 횟수와 실패한 CAS를 센다.
+ */
+static inline int fsem_wait_n(fsem_t *s, int n, futex_stat_t *st)
+{
+    int m, k;
+
+    while ((m = fsem_trywait_n(s, n, st)) == 0) {
+        k = futex_park(&s->count, 0, &s->waiters);
+        if (st != NULL)
+            st->spins += k;
+    }
+    return m;
+}
+
+/*
+ * 세마포 값을 n만큼 올리고, 잠든 스레드가 있으면 최대 n개 깨운다.
+ */
+static inline void fsem_post(fsem_t *s, int n)
+{
+    atomic_fetch_add_explicit(&s->count, n, memory_order_seq_cst);
+    if (atomic_load(&s->waiters) > 0)
+        futex_wake(&s->count, n);
+}
+
+#endif
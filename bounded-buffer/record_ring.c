@@ -0,0 +1,253 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdlib.h>
+#include <limits.h>
+#include "record_ring.h"
+#include "futex.h"
+
+/*
+ * 레코드의 상태
+ *   RRING_BUSY: 생산자가 자리를 받아 쓰는 중이다.
+ *   RRING_READY: 발행되었다. head가 아직 이 레코드 앞에 있으면 소비자에게 보이지 않는다.
+ *   RRING_HELD: 소비자가 받아서 처리하는 중이다.
+ *   RRING_DONE: 처리가 끝났다. tail이 아직 이 레코드 앞에 있으면 생산자가 덮어쓰지 않는다.
+ *   RRING_PAD: 패딩 레코드로, 쓰는 사람도 읽는 사람도 없으므로 head와 tail 모두 그냥 지나간다.
+ */
+#define RRING_BUSY 0
+#define RRING_READY 1
+#define RRING_HELD 2
+#define RRING_DONE 3
+#define RRING_PAD 4
+
+/*
+ * 레코드마다 앞에 붙는 헤더이다. len은 내용의 길이이고, state는 레코드의 상태이다.
+ */
+typedef struct {
+    uint32_t len;
+    _Atomic uint32_t state;
+} rring_hdr_t;
+
+/*
+ * 내용이 len 바이트인 레코드가 버퍼에서 차지하는 바이트 수를 구한다.
+ */
+static size_t record_size(size_t len)
+{
+    return (sizeof(rring_hdr_t) + len + RRING_ALIGN - 1) & ~(size_t)(RRING_ALIGN - 1);
+}
+
+static rring_hdr_t *header_at(rring_t *r, uint64_t pos)
+{
+    return (rring_hdr_t *)(r->base + pos % r->capacity);
+}
+
+/*
+ * pos 위치에 size 바이트를 차지하는 패딩 레코드를 만든다.
+ */
+static void make_pad(rring_t *r, uint64_t pos, size_t size)
+{
+    rring_hdr_t *pad = header_at(r, pos);
+
+    pad->len = (uint32_t)(size - sizeof(rring_hdr_t));
+    atomic_store_explicit(&pad->state, RRING_PAD, memory_order_release);
+}
+
+/*
+ * 바이트 원형 버퍼를 capacity 바이트 크기로 초기화한다.
+ * capacity는 RRING_ALIGN의 배수로 내림한다. 성공하면 RRING_SUCCESS를, 실패하면 RRING_FAIL을 리턴한다.
+ */
+int rring_init(rring_t *r, size_t capacity)
+{
+    capacity &= ~(size_t)(RRING_ALIGN - 1);
+    if (capacity < 2 * sizeof(rring_hdr_t))
+        return RRING_FAIL;
+    r->base = aligned_alloc(SPIN_CACHELINE, (capacity + SPIN_CACHELINE - 1) & ~(size_t)(SPIN_CACHELINE - 1));
+    if (r->base == NULL)
+        return RRING_FAIL;
+    r->capacity = capacity;
+    r->pclaim = r->cclaim = 0;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->nput, 0);
+    atomic_init(&r->nget, 0);
+    atomic_init(&r->cwaiting, 0);
+    atomic_init(&r->pwaiting, 0);
+    spinlock_init(&r->plock, SPIN_TTAS);
+    spinlock_init(&r->clock, SPIN_TTAS);
+    return RRING_SUCCESS;
+}
+
+/*
+ * 바이트 원형 버퍼에 할당된 자원을 반납한다. 버퍼를 사용하는 스레드가 없어야 한다.
+ */
+void rring_destroy(rring_t *r)
+{
+    spinlock_destroy(&r->plock);
+    spinlock_destroy(&r->clock);
+    free(r->base);
+    r->base = NULL;
+}
+
+/*
+ * 생산자: plock을 잡은 채로 head부터 발행된 레코드와 패딩을 지나가며 head를 옮긴다.
+ * 새로 보이게 된 레코드의 수만큼 잠든 소비자를 깨운다. 패딩만 보이게 되었더라도 소비자가 패딩을 지나가야
+ * 공간이 생기므로 하나는 깨운다.
+ */
+static void advance_head(rring_t *r)
+{
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed), from = head;
+    rring_hdr_t *hdr;
+    uint32_t state;
+    int n = 0;
+
+    while (head != r->pclaim) {
+        hdr = header_at(r, head);
+        state = atomic_load_explicit(&hdr->state, memory_order_acquire);
+        if (state == RRING_BUSY)
+            break;
+        n += state == RRING_READY;
+        head += record_size(hdr->len);
+    }
+    if (head == from)
+        return;
+    atomic_store_explicit(&r->head, head, memory_order_release);
+    atomic_fetch_add(&r->nput, 1);
+    if (atomic_load(&r->cwaiting) > 0)
+        futex_wake(&r->nput, n > 0 ? n : 1);
+}
+
+/*
+ * 소비자: clock을 잡은 채로 tail부터 처리가 끝난 레코드와 패딩을 지나가며 tail을 옮긴다.
+ * 생긴 공간에 맞는 생산자가 누구인지 알 수 없으므로, 잠든 생산자를 모두 깨운다.
+ */
+static void advance_tail(rring_t *r)
+{
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed), from = tail;
+    rring_hdr_t *hdr;
+    uint32_t state;
+
+    while (tail != r->cclaim) {
+        hdr = header_at(r, tail);
+        state = atomic_load_explicit(&hdr->state, memory_order_acquire);
+        if (state == RRING_HELD)
+            break;
+        tail += record_size(hdr->len);
+    }
+    if (tail == from)
+        return;
+    atomic_store_explicit(&r->tail, tail, memory_order_release);
+    atomic_fetch_add(&r->nget, 1);
+    if (atomic_load(&r->pwaiting) > 0)
+        futex_wake(&r->nget, INT_MAX);
+}
+
+/*
+ * 생산자: 내용이 len 바이트인 레코드를 쓸 자리를 버퍼 안에 받고 그 주소를 리턴한다.
+ * 생산자는 리턴된 주소에 레코드를 직접 쓴 다음 그 주소로 rring_commit()을 불러야 한다.
+ * 레코드가 버퍼에 들어갈 수 없을 만큼 크면 NULL을 리턴한다.
+ * 버퍼 끝에 남은 공간이 모자라면 남은 공간을 패딩으로 채우고 처음부터 받는다. 패딩은 그 공간만 비면
+ * 먼저 발행하므로, 패딩과 레코드를 합친 크기가 버퍼보다 크더라도 소비자가 패딩을 지나가서 공간이 생긴다.
+ * 공간이 모자라면 plock을 풀고 소비자가 tail을 옮기는 것을 nget에서 기다린다.
+ */
+void *rring_reserve(rring_t *r, size_t len)
+{
+    size_t need = record_size(len), rest, avail;
+    rring_hdr_t *hdr;
+    int seen;
+
+    if (need > r->capacity || len > UINT32_MAX)
+        return NULL;
+    spin_lock(&r->plock, NULL);
+    while (true) {
+        seen = atomic_load(&r->nget);
+        rest = r->capacity - r->pclaim % r->capacity;
+        avail = r->capacity - (r->pclaim - atomic_load_explicit(&r->tail, memory_order_acquire));
+        if (need <= rest && need <= avail)
+            break;
+        if (need > rest && rest <= avail) {
+            make_pad(r, r->pclaim, rest);
+            r->pclaim += rest;
+            advance_head(r);
+            continue;
+        }
+        spin_unlock(&r->plock, NULL);
+        futex_park(&r->nget, seen, &r->pwaiting);
+        spin_lock(&r->plock, NULL);
+    }
+    hdr = header_at(r, r->pclaim);
+    hdr->len = (uint32_t)len;
+    atomic_store_explicit(&hdr->state, RRING_BUSY, memory_order_relaxed);
+    r->pclaim += need;
+    spin_unlock(&r->plock, NULL);
+    return (uint8_t *)hdr + sizeof(rring_hdr_t);
+}
+
+/*
+ * 생산자: rring_reserve()가 리턴한 rec에 쓴 레코드를 발행한다.
+ * len은 실제로 쓴 내용의 길이로, 예약할 때의 길이보다 작거나 같아야 한다. 남는 공간은 패딩으로 채운다.
+ * 앞서 자리를 받은 레코드가 아직 발행되지 않았으면 head는 그 생산자가 발행할 때 이 레코드를 지나간다.
+ */
+void rring_commit(rring_t *r, void *rec, size_t len)
+{
+    rring_hdr_t *hdr = (rring_hdr_t *)((uint8_t *)rec - sizeof(rring_hdr_t));
+    uint64_t pos = (uint8_t *)hdr - r->base;
+    size_t reserved = record_size(hdr->len), size = record_size(len);
+
+    if (size < reserved) {
+        make_pad(r, pos + size, reserved - size);
+        hdr->len = (uint32_t)len;
+    }
+    atomic_store_explicit(&hdr->state, RRING_READY, memory_order_release);
+    spin_lock(&r->plock, NULL);
+    advance_head(r);
+    spin_unlock(&r->plock, NULL);
+}
+
+/*
+ * 소비자: 다음 레코드가 발행될 때까지 기다린 다음 버퍼 안의 레코드 주소를 리턴하고, 길이를 *len에 저장한다.
+ * 소비자는 레코드를 그 자리에서 처리한 다음 그 주소로 rring_release()를 불러야 한다.
+ * 그 사이에 생산자는 이 레코드의 공간을 덮어쓰지 않으며, 다른 소비자는 다음 레코드를 받아 간다.
+ */
+void *rring_peek(rring_t *r, size_t *len)
+{
+    rring_hdr_t *hdr;
+    int seen;
+
+    spin_lock(&r->clock, NULL);
+    while (true) {
+        seen = atomic_load(&r->nput);
+        if (atomic_load_explicit(&r->head, memory_order_acquire) == r->cclaim) {
+            spin_unlock(&r->clock, NULL);
+            futex_park(&r->nput, seen, &r->cwaiting);
+            spin_lock(&r->clock, NULL);
+            continue;
+        }
+        hdr = header_at(r, r->cclaim);
+        r->cclaim += record_size(hdr->len);
+        if (atomic_load_explicit(&hdr->state, memory_order_relaxed) != RRING_PAD)
+            break;
+        /*
+         * 패딩 레코드는 건너뛰고, 공간이 생겼을 수 있으므로 tail을 옮긴다.
+         */
+        advance_tail(r);
+    }
+    atomic_store_explicit(&hdr->state, RRING_HELD, memory_order_relaxed);
+    spin_unlock(&r->clock, NULL);
+    *len = hdr->len;
+    return (uint8_t *)hdr + sizeof(rring_hdr_t);
+}
+
+/*
+ * 소비자: rring_peek()가 리턴한 rec의 처리를 끝내고 그 공간을 생산자에게 돌려준다.
+ * 앞서 받은 레코드를 아직 처리하고 있으면 tail은 그 소비자가 돌려줄 때 이 레코드를 지나간다.
+ */
+void rring_release(rring_t *r, void *rec)
+{
+    rring_hdr_t *hdr = (rring_hdr_t *)((uint8_t *)rec - sizeof(rring_hdr_t));
+
+    atomic_store_explicit(&hdr->state, RRING_DONE, memory_order_release);
+    spin_lock(&r->clock, NULL);
+    advance_tail(r);
+    spin_unlock(&r->clock, NULL);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef RECORD_RING_H
+#define RECORD_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "spinlock.h"
+
+#define RRING_ALIGN 8
+#define RRING_SUCCESS 0
+#define RRING_FAIL 4
+
+/*
+ * 길이가 다른 레코드를 복사 없이 주고받는 바이트 원형 버퍼 구조체 타입
+ *
+ * 레코드는 8바이트 헤더(길이와 상태) 다음에 내용이 오고, RRING_ALIGN 바이트 단위로 정렬된다.
+ * 레코드는 항상 연속된 공간에 놓인다. 버퍼 끝에 남은 공간이 모자라면 그 자리를 패딩 레코드로
+ * 채우고 버퍼의 처음부터 쓴다. 소비자는 패딩 레코드를 보지 못하고 건너뛴다.
+ *
+ * 생산자 쪽의 pclaim과 head, 소비자 쪽의 cclaim과 tail은 지금까지 지나간 바이트 수로, 버퍼 안의 위치는
+ * capacity로 나눈 나머지이다. 생산자는 plock을 잡고 pclaim을 레코드 크기만큼 옮겨서 자리를 받은 다음
+ * 락을 풀고 레코드를 쓴다. 발행할 때는 헤더에 표시만 하고, 다시 plock을 잡아서 head부터 발행이 끝난
+ * 레코드를 건너뛰며 head를 옮긴다. 먼저 받은 자리의 발행이 늦으면 그 뒤의 레코드도 head 밖에 남으므로
+ * 소비자는 언제나 자리를 받은 순서대로 레코드를 본다. 소비자도 clock을 잡고 cclaim을 옮겨서 레코드를 받고,
+ * 처리를 끝내면 헤더에 표시한 다음 tail을 같은 방법으로 옮긴다. head - tail이 현재 사용 중인 바이트 수이다.
+ * 락은 커서를 옮기는 동안에만 잡으며, 공간이나 레코드를 기다리며 잠들 때와 레코드를 쓰고 읽는 동안에는
+ * 잡지 않으므로 여러 생산자와 소비자가 동시에 레코드를 쓰고 처리할 수 있다.
+ * nput과 nget은 head와 tail을 옮긴 횟수로, 레코드나 공간을 기다리는 스레드가 잠드는 futex 변수이다.
+ */
+typedef struct {
+    uint8_t *base;                              /* 레코드를 저장할 바이트 배열 */
+    size_t capacity;                            /* base의 크기 (RRING_ALIGN의 배수) */
+    _Alignas(SPIN_CACHELINE) _Atomic uint64_t head;  /* 발행된 바이트 수 */
+    uint64_t pclaim;                            /* 생산자가 자리를 받은 바이트 수 (plock) */
+    spinlock_t plock;                           /* pclaim과 head를 옮기는 생산자 사이의 상호배타 */
+    atomic_int nput;                            /* head를 옮긴 횟수 (futex) */
+    atomic_int cwaiting;                        /* 레코드를 기다리며 잠든 소비자의 수 */
+    _Alignas(SPIN_CACHELINE) _Atomic uint64_t tail;  /* 돌려준 바이트 수 */
+    uint64_t cclaim;                            /* 소비자가 받은 바이트 수 (clock) */
+    spinlock_t clock;                           /* cclaim과 tail을 옮기는 소비자 사이의 상호배타 */
+    atomic_int nget;                            /* tail을 옮긴 횟수 (futex) */
+    atomic_int pwaiting;                        /* 공간을 기다리며 잠든 생산자의 수 */
+} rring_t;
+
+int rring_init(rring_t *r, size_t capacity);
+void rring_destroy(rring_t *r);
+void *rring_reserve(rring_t *r, size_t len);
+void rring_commit(rring_t *r, void *rec, size_t len);
+void *rring_peek(rring_t *r, size_t *len);
+void rring_release(rring_t *r, void *rec);
+
+#endif
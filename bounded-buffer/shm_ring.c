@@ -0,0 +1,282 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shm_ring.h"
+
+#define SHM_MAGIC 0x45524943
+#define PEER_CHECK_NS 50000000L
+
+/*
+ * 프로세스 사이에서 공유하는 futex이므로 FUTEX_PRIVATE_FLAG를 쓰지 않는다.
+ * 상대가 죽어서 깨워주지 못할 수 있으므로 PEER_CHECK_NS마다 깨어나서 상대를 확인한다.
+ */
+static void futex_wait_shared(atomic_int *addr, int val)
+{
+    struct timespec ts = {0, PEER_CHECK_NS};
+
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void futex_wake_shared(atomic_int *addr, int n)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+/*
+ * role 역할의 상대 프로세스가 살아 있는지 검사한다.
+ * 상대가 붙은 적이 없으면 아직 기다려야 하므로 살아 있는 것으로 본다.
+ * 상대의 robust 뮤텍스를 잡을 수 있으면 상대는 정상적으로 떠났거나 죽은 것이다.
+ */
+static int peer_state(shm_ring_t *r)
+{
+    shm_ring_hdr_t *h = r->hdr;
+    int peer = 1 - r->role;
+    int rc;
+
+    if (!atomic_load(&h->attached[peer]))
+        return SHM_SUCCESS;
+    rc = pthread_mutex_trylock(&h->live[peer]);
+    if (rc == EBUSY)
+        return SHM_SUCCESS;
+    if (rc == EOWNERDEAD) {
+        pthread_mutex_consistent(&h->live[peer]);
+        pthread_mutex_unlock(&h->live[peer]);
+        return SHM_PEER_DEAD;
+    }
+    if (rc == 0)
+        pthread_mutex_unlock(&h->live[peer]);
+    return atomic_load(&h->closed) ? SHM_CLOSED : SHM_PEER_DEAD;
+}
+
+/*
+ * 매핑 크기를 계산한다.
+ */
+static size_t map_size(size_t capacity)
+{
+    return sizeof(shm_ring_hdr_t) + capacity;
+}
+
+/*
+ * 익명 공유 메모리 파일(memfd)을 만들고 capacity 바이트의 원형 버퍼를 초기화한다.
+ * 만들어진 r->fd는 fork()로 자식에게 물려주거나 유닉스 소켓으로 다른 프로세스에 넘길 수 있다.
+ * 성공하면 SHM_SUCCESS를, 실패하면 SHM_FAIL을 리턴한다.
+ */
+int shm_ring_create(shm_ring_t *r, size_t capacity)
+{
+    pthread_mutexattr_t attr;
+    shm_ring_hdr_t *h;
+
+    if (capacity == 0 || capacity > UINT32_MAX)
+        return SHM_FAIL;
+    r->fd = memfd_create("bounded-buffer", MFD_CLOEXEC);
+    if (r->fd < 0)
+        return SHM_FAIL;
+    r->mapsize = map_size(capacity);
+    r->role = -1;
+    if (ftruncate(r->fd, (off_t)r->mapsize) != 0)
+        goto fail;
+    h = mmap(NULL, r->mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0);
+    if (h == MAP_FAILED)
+        goto fail;
+    r->hdr = h;
+    h->capacity = (uint32_t)capacity;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&h->live[SHM_PRODUCER], &attr);
+    pthread_mutex_init(&h->live[SHM_CONSUMER], &attr);
+    pthread_mutexattr_destroy(&attr);
+    atomic_init(&h->attached[SHM_PRODUCER], 0);
+    atomic_init(&h->attached[SHM_CONSUMER], 0);
+    atomic_init(&h->closed, 0);
+    atomic_init(&h->head, 0);
+    atomic_init(&h->tail, 0);
+    atomic_init(&h->nput, 0);
+    atomic_init(&h->nget, 0);
+    atomic_init(&h->cwaiting, 0);
+    atomic_init(&h->pwaiting, 0);
+    h->magic = SHM_MAGIC;
+    return SHM_SUCCESS;
+fail:
+    close(r->fd);
+    r->fd = -1;
+    return SHM_FAIL;
+}
+
+/*
+ * 다른 프로세스가 shm_ring_create()로 만든 공유 메모리 파일 fd를 매핑한다.
+ */
+int shm_ring_open(shm_ring_t *r, int fd)
+{
+    struct stat st;
+    shm_ring_hdr_t *h;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_ring_hdr_t))
+        return SHM_FAIL;
+    h = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED)
+        return SHM_FAIL;
+    if (h->magic != SHM_MAGIC || map_size(h->capacity) != (size_t)st.st_size) {
+        munmap(h, (size_t)st.st_size);
+        return SHM_FAIL;
+    }
+    r->fd = fd;
+    r->mapsize = (size_t)st.st_size;
+    r->hdr = h;
+    r->role = -1;
+    return SHM_SUCCESS;
+}
+
+/*
+ * 매핑을 해제하고 파일을 닫는다. 붙어 있으면 먼저 떨어진다.
+ */
+void shm_ring_close(shm_ring_t *r)
+{
+    if (r->role >= 0)
+        shm_ring_detach(r);
+    munmap(r->hdr, r->mapsize);
+    close(r->fd);
+    r->hdr = NULL;
+    r->fd = -1;
+}
+
+/*
+ * 생산자(SHM_PRODUCER) 또는 소비자(SHM_CONSUMER)로 원형 버퍼에 붙는다.
+ * 각 역할에는 한 프로세스(스레드)만 붙을 수 있으며, 붙은 스레드가 읽기나 쓰기를 해야 한다.
+ * 이전에 같은 역할의 프로세스가 죽었으면 그 뮤텍스를 회복시키고 붙는다.
+ */
+int shm_ring_attach(shm_ring_t *r, int role)
+{
+    shm_ring_hdr_t *h = r->hdr;
+    int rc;
+
+    if (role != SHM_PRODUCER && role != SHM_CONSUMER)
+        return SHM_FAIL;
+    rc = pthread_mutex_trylock(&h->live[role]);
+    if (rc == EOWNERDEAD)
+        pthread_mutex_consistent(&h->live[role]);
+    else if (rc != 0)
+        return SHM_FAIL;
+    r->role = role;
+    atomic_store(&h->attached[role], 1);
+    return SHM_SUCCESS;
+}
+
+/*
+ * 원형 버퍼에서 떨어진다. 생산자가 떨어지면 소비자는 남은 데이터를 모두 읽은 뒤 SHM_CLOSED를 받는다.
+ */
+void shm_ring_detach(shm_ring_t *r)
+{
+    shm_ring_hdr_t *h = r->hdr;
+
+    if (r->role < 0)
+        return;
+    if (r->role == SHM_PRODUCER) {
+        atomic_store(&h->closed, 1);
+        atomic_fetch_add(&h->nput, 1);
+        futex_wake_shared(&h->nput, 1);
+    }
+    else {
+        atomic_fetch_add(&h->nget, 1);
+        futex_wake_shared(&h->nget, 1);
+    }
+    pthread_mutex_unlock(&h->live[r->role]);
+    r->role = -1;
+}
+
+/*
+ * 생산자: buf의 len 바이트를 모두 쓸 때까지 원형 버퍼에 복사한다.
+ * 공간이 없으면 소비자가 읽을 때까지 잠든다. 소비자가 죽거나 떠나면 SHM_PEER_DEAD를 리턴한다.
+ */
+int shm_ring_write(shm_ring_t *r, const void *buf, size_t len)
+{
+    shm_ring_hdr_t *h = r->hdr;
+    const uint8_t *p = buf;
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    size_t cap = h->capacity, room, n, off, first;
+    int seen, rc;
+
+    while (len > 0) {
+        seen = atomic_load(&h->nget);
+        room = cap - (size_t)(head - atomic_load_explicit(&h->tail, memory_order_acquire));
+        if (room == 0) {
+            if ((rc = peer_state(r)) != SHM_SUCCESS)
+                return rc == SHM_CLOSED ? SHM_PEER_DEAD : rc;
+            atomic_fetch_add(&h->pwaiting, 1);
+            futex_wait_shared(&h->nget, seen);
+            atomic_fetch_sub(&h->pwaiting, 1);
+            continue;
+        }
+        /*
+         * 빈 공간에 최대 두 조각으로 나눠서 복사한 다음 head를 옮겨 발행한다.
+         */
+        n = len < room ? len : room;
+        off = head % cap;
+        first = cap - off < n ? cap - off : n;
+        memcpy(h->data + off, p, first);
+        memcpy(h->data, p + first, n - first);
+        head += n;
+        atomic_store_explicit(&h->head, head, memory_order_release);
+        atomic_fetch_add(&h->nput, 1);
+        if (atomic_load(&h->cwaiting) > 0)
+            futex_wake_shared(&h->nput, 1);
+        p += n;
+        len -= n;
+    }
+    return SHM_SUCCESS;
+}
+
+/*
+ * 소비자: 원형 버퍼에서 최대 size 바이트를 buf로 읽고, 읽은 바이트 수를 *len에 저장한다.
+ * 데이터가 없으면 생길 때까지 잠든다. 생산자가 정상적으로 떠났고 데이터를 모두 읽었으면 SHM_CLOSED를,
+ * 생산자가 죽었으면 남은 데이터를 모두 읽은 다음 SHM_PEER_DEAD를 리턴한다.
+ */
+int shm_ring_read(shm_ring_t *r, void *buf, size_t size, size_t *len)
+{
+    shm_ring_hdr_t *h = r->hdr;
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    size_t cap = h->capacity, avail, n, off, first;
+    int seen, rc;
+
+    *len = 0;
+    while (true) {
+        seen = atomic_load(&h->nput);
+        avail = (size_t)(atomic_load_explicit(&h->head, memory_order_acquire) - tail);
+        if (avail > 0)
+            break;
+        /*
+         * 생산자가 떠나기 직전에 쓴 데이터가 있을 수 있으므로 head를 한 번 더 확인한다.
+         */
+        if ((rc = peer_state(r)) != SHM_SUCCESS) {
+            if (atomic_load(&h->head) != tail)
+                continue;
+            return rc;
+        }
+        atomic_fetch_add(&h->cwaiting, 1);
+        futex_wait_shared(&h->nput, seen);
+        atomic_fetch_sub(&h->cwaiting, 1);
+    }
+    n = size < avail ? size : avail;
+    off = tail % cap;
+    first = cap - off < n ? cap - off : n;
+    memcpy(buf, h->data + off, first);
+    memcpy((uint8_t *)buf + first, h->data, n - first);
+    atomic_store_explicit(&h->tail, tail + n, memory_order_release);
+    atomic_fetch_add(&h->nget, 1);
+    if (atomic_load(&h->pwaiting) > 0)
+        futex_wake_shared(&h->nget, 1);
+    *len = n;
+    return SHM_SUCCESS;
+}
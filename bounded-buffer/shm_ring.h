@@ -0,0 +1,64 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define SHM_PRODUCER 0
+#define SHM_CONSUMER 1
+#define SHM_SUCCESS 0
+#define SHM_FAIL 4
+#define SHM_CLOSED 5
+#define SHM_PEER_DEAD 6
+#define SHM_CACHELINE 64
+
+/*
+ * 두 프로세스가 공유 메모리에 두고 함께 사용하는 원형 버퍼의 헤더 구조체 타입
+ *
+ * 헤더 바로 뒤에 capacity 바이트의 데이터 영역이 이어진다.
+ * head와 tail은 지금까지 쓴 바이트 수와 읽은 바이트 수이다. 생산자만 head를, 소비자만 tail을 바꾼다.
+ * nput과 nget은 쓰기와 읽기 횟수로, 기다리는 프로세스가 잠드는 프로세스 공유 futex 변수이다.
+ * live[]는 생산자와 소비자가 붙어 있는 동안 계속 잡고 있는 robust 뮤텍스이다.
+ * 상대 프로세스가 뮤텍스를 잡은 채로 죽으면 커널이 EOWNERDEAD로 알려주므로 죽은 것을 확실히 알 수 있다.
+ * attached[]는 각 역할의 프로세스가 붙은 적이 있는지, closed는 생산자가 정상적으로 끝냈는지를 나타낸다.
+ */
+typedef struct {
+    uint32_t magic;                                     /* 올바르게 초기화된 영역인지 확인하는 값 */
+    uint32_t capacity;                                  /* 데이터 영역의 크기 */
+    pthread_mutex_t live[2];                            /* 생산자, 소비자의 생존 표시 (robust) */
+    atomic_int attached[2];                             /* 생산자, 소비자가 붙은 적이 있으면 1 */
+    atomic_int closed;                                  /* 생산자가 더 이상 쓰지 않으면 1 */
+    _Alignas(SHM_CACHELINE) _Atomic uint64_t head;      /* 지금까지 쓴 바이트 수 */
+    atomic_int nput;                                    /* 쓰기 횟수 (futex) */
+    atomic_int cwaiting;                                /* 데이터를 기다리며 잠든 소비자 */
+    _Alignas(SHM_CACHELINE) _Atomic uint64_t tail;      /* 지금까지 읽은 바이트 수 */
+    atomic_int nget;                                    /* 읽기 횟수 (futex) */
+    atomic_int pwaiting;                                /* 공간을 기다리며 잠든 생산자 */
+    _Alignas(SHM_CACHELINE) uint8_t data[];             /* 데이터 영역 */
+} shm_ring_hdr_t;
+
+/*
+ * 각 프로세스가 자신의 매핑을 가리키기 위해 가지는 정보
+ */
+typedef struct {
+    int fd;                     /* 공유 메모리 파일(memfd)의 디스크립터 */
+    size_t mapsize;             /* 매핑의 전체 크기 */
+    shm_ring_hdr_t *hdr;        /* 매핑된 헤더와 데이터 영역 */
+    int role;                   /* 붙은 역할, 붙지 않았으면 -1 */
+} shm_ring_t;
+
+int shm_ring_create(shm_ring_t *r, size_t capacity);
+int shm_ring_open(shm_ring_t *r, int fd);
+void shm_ring_close(shm_ring_t *r);
+int shm_ring_attach(shm_ring_t *r, int role);
+void shm_ring_detach(shm_ring_t *r);
+int shm_ring_write(shm_ring_t *r, const void *buf, size_t len);
+int shm_ring_read(shm_ring_t *r, void *buf, size_t size, size_t *len);
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#include <stdlib.h>
+#include <sched.h>
+#include "spinlock.h"
+
+#define BACKOFF_MIN 4
+#define BACKOFF_MAX 1024
+#define YIELD_AFTER 256
+
+/*
+ * 스핀 루프 안에서 CPU에게 잠시 쉬어도 된다고 알려준다.
+ * 하이퍼스레드 형제에게 자원을 양보하고, 루프를 빠져나올 때 파이프라인 비용을 줄인다.
+ */
+void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/*
+ * 대기 루프에서 한 번 쉰다. YIELD_AFTER 번 넘게 돌았으면 CPU를 양보한다.
+ * 코어보다 스레드가 많으면 락을 넘겨받을 스레드가 실행되지 못하고 있을 수 있기 때문이다.
+ * node가 있으면 돈 횟수를 센다.
+ */
+static void spin_pause(unsigned *spins, spin_node_t *node)
+{
+    if (node != NULL)
+        node->spins++;
+    if (++*spins < YIELD_AFTER) {
+        cpu_relax();
+    }
+    else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+/*
+ * 캐시라인 경계에 맞춘 큐 노드를 하나 할당한다.
+ */
+static spin_qnode_t *qnode_alloc(void)
+{
+    spin_qnode_t *q = aligned_alloc(SPIN_CACHELINE, sizeof(spin_qnode_t));
+
+    if (q == NULL)
+        return NULL;
+    atomic_init(&q->next, NULL);
+    atomic_init(&q->locked, false);
+    return q;
+}
+
+/*
+ * 스핀락을 type 종류로 초기화한다. 성공하면 SPIN_SUCCESS를, 실패하면 SPIN_FAIL을 리턴한다.
+ * CLH는 대기열이 비어 있어도 tail이 풀린 상태의 더미 노드를 가리키고 있어야 한다.
+ */
+int spinlock_init(spinlock_t *lock, int type)
+{
+    if (type < SPIN_TTAS || type > SPIN_CLH)
+        return SPIN_FAIL;
+    lock->type = type;
+    atomic_init(&lock->flag, 0);
+    atomic_init(&lock->next, 0);
+    atomic_init(&lock->serving, 0);
+    atomic_init(&lock->tail, NULL);
+    if (type == SPIN_CLH) {
+        spin_qnode_t *dummy = qnode_alloc();
+        if (dummy == NULL)
+            return SPIN_FAIL;
+        atomic_init(&lock->tail, dummy);
+    }
+    return SPIN_SUCCESS;
+}
+
+/*
+ * 스핀락이 사용하던 자원을 반납한다. 락을 기다리거나 가진 스레드가 없어야 한다.
+ */
+void spinlock_destroy(spinlock_t *lock)
+{
+    if (lock->type == SPIN_CLH)
+        free(atomic_load(&lock->tail));
+    atomic_store(&lock->tail, NULL);
+}
+
+/*
+ * 스레드가 사용할 큐 노드를 준비한다. 성공하면 SPIN_SUCCESS를, 실패하면 SPIN_FAIL을 리턴한다.
+ * CLH에서 노드는 스레드 사이를 옮겨다니므로 스택이 아닌 힙에 할당한다.
+ */
+int spin_node_init(spin_node_t *node)
+{
+    node->pred = NULL;
+    node->spins = node->fails = 0;
+    node->mine = qnode_alloc();
+    return node->mine == NULL ? SPIN_FAIL : SPIN_SUCCESS;
+}
+
+/*
+ * 스레드가 현재 가지고 있는 노드를 반납한다.
+ * CLH에서 노드가 바뀌었더라도 노드의 총 개수는 변하지 않으므로 누수나 중복 해제가 없다.
+ */
+void spin_node_destroy(spin_node_t *node)
+{
+    free(node->mine);
+    node->mine = node->pred = NULL;
+}
+
+/*
+ * TTAS: 락이 풀린 것을 읽기로 먼저 확인한 다음에만 원자적 교환을 시도한다.
+ * 실패하면 기다리는 시간을 두 배씩 늘려서 같은 캐시라인을 두드리는 횟수를 줄인다.
+ */
+static void ttas_lock(spinlock_t *lock, spin_node_t *node)
+{
+    int backoff = BACKOFF_MIN;
+    unsigned spins = 0;
+
+    while (true) {
+        while (atomic_load_explicit(&lock->flag, memory_order_relaxed))
+            spin_pause(&spins, node);
+        if (!atomic_exchange_explicit(&lock->flag, 1, memory_order_acquire))
+            return;
+        if (node != NULL)
+            node->fails++;
+        for (int k = 0; k < backoff; ++k)
+            spin_pause(&spins, node);
+        if (backoff < BACKOFF_MAX)
+            backoff <<= 1;
+    }
+}
+
+/*
+ * 티켓 락: 번호표를 받고 자기 차례가 될 때까지 기다린다. 도착한 순서대로 들어가므로 공정하다.
+ * 앞에 기다리는 스레드 수에 비례해서 쉬므로 serving을 읽는 횟수가 줄어든다.
+ */
+static void ticket_lock(spinlock_t *lock, spin_node_t *node)
+{
+    unsigned my = atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+    unsigned now, spins = 0;
+
+    while ((now = atomic_load_explicit(&lock->serving, memory_order_acquire)) != my)
+        for (unsigned k = 0; k < (my - now) * BACKOFF_MIN; ++k)
+            spin_pause(&spins, node);
+}
+
+/*
+ * MCS: 자기 노드를 대기열 끝에 붙이고 자기 노드의 locked만 보면서 돈다.
+ * 앞선 스레드가 락을 풀 때 직접 locked를 false로 바꿔서 넘겨준다.
+ */
+static void mcs_lock(spinlock_t *lock, spin_node_t *node)
+{
+    spin_qnode_t *me = node->mine;
+    spin_qnode_t *pred;
+    unsigned spins = 0;
+
+    atomic_store_explicit(&me->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&me->locked, true, memory_order_relaxed);
+    pred = atomic_exchange_explicit(&lock->tail, me, memory_order_acq_rel);
+    if (pred == NULL)
+        return;
+    atomic_store_explicit(&pred->next, me, memory_order_release);
+    while (atomic_load_explicit(&me->locked, memory_order_acquire))
+        spin_pause(&spins, node);
+}
+
+static void mcs_unlock(spinlock_t *lock, spin_node_t *node)
+{
+    spin_qnode_t *me = node->mine;
+    spin_qnode_t *succ = atomic_load_explicit(&me->next, memory_order_acquire);
+    unsigned spins = 0;
+
+    if (succ == NULL) {
+        /*
+         * 뒤에 아무도 없으면 tail을 비운다. 그 사이에 누가 붙었다면 next가 채워질 때까지 기다린다.
+         */
+        spin_qnode_t *expected = me;
+        if (atomic_compare_exchange_strong_explicit(&lock->tail, &expected, NULL,
+                                                    memory_order_acq_rel, memory_order_relaxed))
+            return;
+        node->fails++;
+        while ((succ = atomic_load_explicit(&me->next, memory_order_acquire)) == NULL)
+            spin_pause(&spins, node);
+    }
+    atomic_store_explicit(&succ->locked, false, memory_order_release);
+}
+
+/*
+ * CLH: 자기 노드를 대기열 끝에 붙이고 앞선 노드의 locked를 보면서 돈다.
+ * 락을 풀 때는 자기 노드를 풀어주고, 앞선 노드를 다음 번에 쓸 노드로 가져간다.
+ */
+static void clh_lock(spinlock_t *lock, spin_node_t *node)
+{
+    spin_qnode_t *me = node->mine;
+    spin_qnode_t *pred;
+    unsigned spins = 0;
+
+    atomic_store_explicit(&me->locked, true, memory_order_relaxed);
+    pred = atomic_exchange_explicit(&lock->tail, me, memory_order_acq_rel);
+    while (atomic_load_explicit(&pred->locked, memory_order_acquire))
+        spin_pause(&spins, node);
+    node->pred = pred;
+}
+
+static void clh_unlock(spin_node_t *node)
+{
+    spin_qnode_t *me = node->mine;
+
+    node->mine = node->pred;
+    atomic_store_explicit(&me->locked, false, memory_order_release);
+}
+
+/*
+ * 스핀락을 획득한다. MCS와 CLH는 spin_node_init()으로 준비한 스레드 자신의 노드가 필요하다.
+ */
+void spin_lock(spinlock_t *lock, spin_node_t *node)
+{
+    switch (lock->type) {
+        case SPIN_TTAS:
+            ttas_lock(lock, node);
+            break;
+        case SPIN_TICKET:
+            ticket_lock(lock, node);
+            break;
+        case SPIN_MCS:
+            mcs_lock(lock, node);
+            break;
+        case SPIN_CLH:
+            clh_lock(lock, node);
+            break;
+        default:
+            ;
+    }
+}
+
+/*
+ * 스핀락을 푼다. 락을 얻을 때 사용한 것과 같은 노드를 넘겨야 한다.
+ */
+void spin_unlock(spinlock_t *lock, spin_node_t *node)
+{
+    switch (lock->type) {
+        case SPIN_TTAS:
+            atomic_store_explicit(&lock->flag, 0, memory_order_release);
+            break;
+        case SPIN_TICKET:
+            atomic_store_explicit(&lock->serving,
+                                  atomic_load_explicit(&lock->serving, memory_order_relaxed) + 1,
+                                  memory_order_release);
+            break;
+        case SPIN_MCS:
+            mcs_unlock(lock, node);
+            break;
+        case SPIN_CLH:
+            clh_unlock(node);
+            break;
+        default:
+            ;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위해 교육용으로 제작되었다.
+ */
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define SPIN_TTAS 0
+#define SPIN_TICKET 1
+#define SPIN_MCS 2
+#define SPIN_CLH 3
+#define SPIN_SUCCESS 0
+#define SPIN_FAIL 4
+#define SPIN_CACHELINE 64
+
+/*
+ * MCS와 CLH 큐 락에서 대기열을 이루는 노드 구조체 타입
+ *
+ * 각 노드는 캐시라인 하나를 혼자 차지하므로 스레드는 자기 노드(MCS) 또는
+ * 바로 앞 노드(CLH)만 보면서 돌고, 다른 스레드의 캐시라인을 건드리지 않는다.
+ */
+typedef struct spin_qnode {
+    _Alignas(SPIN_CACHELINE) struct spin_qnode *_Atomic next;  /* MCS: 뒤에서 기다리는 노드 */
+    atomic_bool locked;                                         /* true이면 아직 기다려야 함 */
+} spin_qnode_t;
+
+/*
+ * 스레드마다 하나씩 가지는 락 획득용 정보
+ *
+ * mine은 락을 얻을 때 대기열에 넣을 노드이고, pred는 CLH에서 앞선 스레드의 노드이다.
+ * CLH는 락을 풀 때 앞선 노드를 넘겨받아 다음 번에 재사용하므로 mine이 바뀔 수 있다.
+ * TTAS와 티켓 락은 노드가 필요 없으므로 NULL을 넘겨도 된다.
+ * spins와 fails는 이 스레드가 락을 기다리며 돈 횟수와 실패한 원자적 교환(CAS)의 횟수이다.
+ * 노드를 넘긴 경우에만 세며, 소유한 스레드만 고치므로 원자 변수가 아니다.
+ */
+typedef struct {
+    spin_qnode_t *mine;     /* 대기열에 넣을 자신의 노드 */
+    spin_qnode_t *pred;     /* CLH: 앞선 스레드의 노드 */
+    unsigned long spins;    /* 통계: 락을 기다리며 돈 횟수 */
+    unsigned long fails;    /* 통계: 실패한 원자적 교환의 횟수 */
+} spin_node_t;
+
+/*
+ * 네 가지 스핀락이 공유하는 스핀락 구조체 타입
+ *
+ * type은 SPIN_TTAS, SPIN_TICKET, SPIN_MCS, SPIN_CLH 중 하나이다.
+ * flag는 TTAS가 사용하는 락 변수이다.
+ * next와 serving은 티켓 락의 발급 번호와 현재 들어갈 수 있는 번호이다.
+ * 번호를 받는 스레드와 기다리는 스레드가 서로 다른 캐시라인을 보도록 serving을 떼어 놓는다.
+ * tail은 MCS와 CLH 대기열의 마지막 노드를 가리킨다.
+ */
+typedef struct {
+    int type;                                                   /* 스핀락의 종류 */
+    _Alignas(SPIN_CACHELINE) atomic_int flag;                   /* TTAS 락 변수 */
+    _Alignas(SPIN_CACHELINE) atomic_uint next;                  /* 티켓 락의 다음 발급 번호 */
+    _Alignas(SPIN_CACHELINE) atomic_uint serving;               /* 티켓 락의 현재 번호 */
+    _Alignas(SPIN_CACHELINE) spin_qnode_t *_Atomic tail;        /* MCS, CLH 대기열의 끝 */
+} spinlock_t;
+
+int spinlock_init(spinlock_t *lock, int type);
+void spinlock_destroy(spinlock_t *lock);
+int spin_node_init(spin_node_t *node);
+void spin_node_destroy(spin_node_t *node);
+void spin_lock(spinlock_t *lock, spin_node_t *node);
+void spin_unlock(spinlock_t *lock, spin_node_t *node);
+void cpu_relax(void);
+
+#endif
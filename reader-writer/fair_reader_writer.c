@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <pthread.h>
+#include "outbuf.h"
+#include "pflock.h"
 
 #define L0 8192
 #define L1 50
@@ -343,64 +345,52 @@ char *img5[L5] = {
  * alive 값이 0이 되면 무한 루프를 빠져나와 스레드를 자연스럽게 종료한다.
  */
 int alive = 1;
-pthread_mutex_t mutex; //공유 변수 통제를 위한 lock
-pthread_mutex_t wrt; //writer중복을 막기 위한 lock
-pthread_mutex_t fair; //reader & writer의 starvation을 막기 위한 lock
-int readcnt = 0; //중복된 reader의 갯수 변수
+
+/*
+ * reader와 writer가 함께 쓰는 티켓 기반 phase-fair 락이다. 작동 원리는 pflock.h와 파일 끝의 설명에 있다.
+ */
+pflock_t rw;
 
 /*
  * Reader 스레드는 같은 문자를 L0번 출력한다. 예를 들면 <AAA...AA> 이런 식이다.
  * 출력할 문자는 인자를 통해 0이면 A, 1이면 B, ..., 등으로 출력하며, 시작과 끝을 <...>로 나타낸다.
- * 단일 reader라면 <AAA...AA>처럼 같은 문자만 출력하겠지만, critical section에서 reader의
- * 중복을 허용하기 때문에 reader가 많아지면 출력이 어지럽게 섞여서 나오는 것이 정상이다.
+ * 시퀀스는 스레드의 출력 버퍼에 모았다가 cs 안에서 writev 한 번으로 내보내서 시스템 호출의 수를 줄인다.
+ * 그렇다고 문자가 섞이지 않는 것은 아니다. 출력이 파이프이면 PIPE_BUF보다 긴 쓰기는 원자적이지 않고,
+ * ob_flush()가 일부만 쓰인 나머지를 다시 쓰기 때문에, 동시에 쓰는 reader의 시퀀스가 섞일 수 있다.
+ * 또 critical section에서 reader의 중복을 허용하기 때문에, writer 이미지 사이에 여러 reader의 시퀀스가
+ * 이어서 나오는 것이 정상이다.
  */
 void *reader(void *arg)
 {
-    int id, i;
+    int id;
+    outbuf_t ob;
 
     /*
      * 들어온 인자를 통해 출력할 문자의 종류를 정한다.
      */
     id = *(int *)arg;
+    ob_init(&ob, STDOUT_FILENO);
     /*
      * 스레드가 살아 있는 동안 같은 문자열 시퀀스 <XXX...XX>를 반복해서 출력한다.
      */
     while (alive) {
-	      pthread_mutex_lock(&fair); //fair 획득 -> reader 실행
-
-        /* 공유 변수 통제 */
-        pthread_mutex_lock(&mutex);
-        // 첫번째 reader라면 writer의 출입을 막는다.
-        if(readcnt == 0) {
-          pthread_mutex_lock(&wrt); 
-        }
-        readcnt++;
-        // fair_lock을 풀어 다음 실행할 쓰레드에게 순서를 넘겨준다.
-        pthread_mutex_unlock(&fair); 
-        pthread_mutex_unlock(&mutex);
-        /* 공유 변수 통제 */
+        /*
+         * writer가 cs에 있거나 차례를 받았으면 그 writer가 나올 때까지만 기다린다.
+         */
+        pf_rdlock(&rw);
 
         /*
          * Begin Critical Section
          */
-        printf("<");
-        for (i = 0; i < L0; ++i)
-            printf("%c", 'A'+id);
-        printf(">");
+        ob_putc(&ob, '<');
+        ob_fill(&ob, 'A'+id, L0);
+        ob_putc(&ob, '>');
+        ob_flush(&ob);
 
         /*
          * End Critical Section
          */
-
-         /* 공유 변수 통제 */
-         pthread_mutex_lock(&mutex);
-         readcnt--;
-         // 중복된 reader들이 다 읽었다면 writer의 출입을 허용한다.
-         if(readcnt == 0) {
-           pthread_mutex_unlock(&wrt); 
-         }
-         pthread_mutex_unlock(&mutex);
-         /* 공유 변수 통제 */
+        pf_rdunlock(&rw);
     }
     pthread_exit(NULL);
 }
@@ -409,73 +399,79 @@ void *reader(void *arg)
  * Writer 스레드는 어떤 사람의 얼굴 이미지를 출력한다.
  * 이미지는 여러 종류가 있으며 인자를 통해 식별한다.
  * Writer가 critical section에 있으면 다른 writer는 물론이고 어떠한 reader도 들어올 수 없다.
- * 만일 이것을 어기고 다른 writer나 reader가 들어왔다면 얼굴 이미지가 깨져서 쉽게 감지된다.
+ * 이미지는 줄마다 printf를 부르지 않고 출력 버퍼에 모은 줄들을 writev 한 번으로 내보낸다.
+ * 따라서 이것을 어기고 들어온 스레드가 있어도 이미지가 깨져 보이지 않으므로, 상호배타는 출력 모양이 아니라
+ * 락의 공유 변수로 확인해야 한다.
  */
 void *writer(void *arg)
 {
     int id, i;
     struct timespec req;
+    outbuf_t ob;
 
     /*
      * 들어온 인자를 통해 얼굴 이미지의 종류를 정한다.
      * 랜덤 생성기의 시드 값을 현재 시간으로 초기화한다.
      */
     id = *(int *)arg;
+    ob_init(&ob, STDOUT_FILENO);
     srand(time(NULL));
     /*
      * 스레드가 살아 있는 동안 같은 이미지를 반복해서 출력한다.
      */
     while (alive) {
-        // fair 획득 -> writer 실행
-        pthread_mutex_lock(&fair); 
-        /* 
-         * fair을 획득한 후에 wrt_lock을 기다림으로써
-         * 이전에 중복된 reader들의 실행이 종료될때까지
-         * 기다림과 동시에 새로운 reader의 진입을 막는다. 
-         */
-        pthread_mutex_lock(&wrt); 
         /*
-         * fair_lock을 풀어주어 다음에 실행될 writer 혹은 reader의 대기를 허용함
+         * 티켓 순서대로 writer 차례를 기다린 다음, 새 reader를 막고 이미 들어간 reader가 나오기를 기다린다.
          */
-	    pthread_mutex_unlock(&fair); 
+        pf_wrlock(&rw);
 
         /*
          * Begin Critical Section
          */
-        printf("\n");
+        ob_putc(&ob, '\n');
         switch (id) {
             case 0:
-                for (i = 0; i < L1; ++i)
-                    printf("%s\n", img1[i]);
+                for (i = 0; i < L1; ++i) {
+                    ob_ref(&ob, img1[i], strlen(img1[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 1:
-                for (i = 0; i < L2; ++i)
-                    printf("%s\n", img2[i]);
+                for (i = 0; i < L2; ++i) {
+                    ob_ref(&ob, img2[i], strlen(img2[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 2:
-                for (i = 0; i < L3; ++i)
-                    printf("%s\n", img3[i]);
+                for (i = 0; i < L3; ++i) {
+                    ob_ref(&ob, img3[i], strlen(img3[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 3:
-                for (i = 0; i < L4; ++i)
-                    printf("%s\n", img4[i]);
+                for (i = 0; i < L4; ++i) {
+                    ob_ref(&ob, img4[i], strlen(img4[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 4:
-                for (i = 0; i < L5; ++i)
-                    printf("%s\n", img5[i]);
+                for (i = 0; i < L5; ++i) {
+                    ob_ref(&ob, img5[i], strlen(img5[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             default:
                 ;
         }
+        ob_flush(&ob);
 
         /*
          * End Critical Section
          */
-        /* 
-         * writing이 종료되었음 알려준다. -> reader 혹은 writer 중에
-         * fair_lock을 획득한 쓰레드에게 wrt를 넘겨주는 원리이다. 
+        /*
+         * writer 비트를 지워서 기다리던 reader를 한꺼번에 들여보내고 다음 writer에게 차례를 넘긴다.
          */
-         pthread_mutex_unlock(&wrt); 
+        pf_wrunlock(&rw);
 
         /*
          * 이미지 출력 후 SLEEPTIME 나노초 안에서 랜덤하게 쉰다.
@@ -502,9 +498,7 @@ int main(void)
     /*
      * Create lock
      */
-    pthread_mutex_init(&mutex, NULL);
-    pthread_mutex_init(&wrt, NULL);
-    pthread_mutex_init(&fair, NULL);
+    pf_init(&rw);
     /*
      * Create NREAD reader threads
      */
@@ -539,46 +533,39 @@ int main(void)
         pthread_join(rthid[i], NULL);
     for (i = 0; i < NWRITE; ++i)
         pthread_join(wthid[i], NULL);
-
-    /*
-     * Destroy all locks
-     */
-     pthread_mutex_destroy(&mutex);
-     pthread_mutex_destroy(&wrt);
-     pthread_mutex_destroy(&fair);
     exit(0);
 }
 
 /* 공정한 reader-writer 알고리즘 */
-/* 공정한 reader-writer를 구현하기 위해 총 3개의 lock을 생성했다. 공유 변수 readcnt를 통제하기 위한
-   mutex_lock과 writer의 중복을 막는 lock 그리고 reader와 writer의 순서를 만들기위한 lock 총 3개의 lock을 만들었다.
- * 작동 원리 : writer와 reader 둘 중 누구나 fair락을 획득할 수 있다. 두 함수 도입에 fair wait을 사용했으므로 획득하는 순서대로 프로세스가 진행한다.
- * 1. reader가 fair를 획득했다면 readcnt의 값을 확인한다.readcnt는 공유변수이므로 mutex_lock을 걸고 확인해야힌다.
-      readcnt가 0이라면 자신이 중복된 reader가 아니므로 writer의 출입을 막고 자신이 곧 실행할 것이므로
-      readcnt를 하나 늘려준후 fair와 mutex_lock 둘다 풀어준다.
-      reader함수의 실행은 lock을 걸지 않으므로 reader의 중복은 허용된다.
-      reader의 실행을 완료하면 readcnt가 0이라면 더이상 중복해서 실행할 reader가 존재하지 않는 것 이므로 wrt_lock을 풀어 writer의 출입을 허용한다.
-      *** lock을 풀어 출입 혹은 중복을 허용한다고 해서 이후 실행을 강제하진 않는다. writer의 출입을 허용하지만 reader가 fair을 획득했다면 reader를 실행한다. ***
- * 2. writer가 fair를 획득했다면 writer는 wrt_lock을 기다린다. 이 과정은 3개의 의미를 가진다.
-          a. 앞에서 실행되고 있는 reader들의 종료를 기다린다. (reader와 writer는 중복될 수 없기 때문)
-          b. 새로운 reader의 출입을 막는다. (기다리는 중에 새로운 reader가 추가되어 먼저 실행된다면 공정하지 않기 때문)
-          c. writer의 중복을 막는다. (writer의 중복은 허용하지 않기 때문)
-      wrt_lock을 획득했다면 fair를 풀어주어 reader와 writer 둘 다 출입을 허용한다. (둘 중 fair를 획득하는 프로세스가 실행됨)
-        -> 해당 과정은 reader와 writer의 순서를 결정해준다.
-      writer의 실행을 완료하면 wrt_lock을 풀어주어 reader와 writer의 실행을 허용한다.
-        -> 해당 과정은 readerdhk wrtier의 실행을 결정해준다.    */
+/* 처음에는 fair, mutex, wrt 세 개의 뮤텍스락을 쌓아서 fair를 잡는 순서대로 진행했다. 하지만 누가 fair를 먼저
+   잡는지는 운에 맡겨져 있었고, 첫 reader가 잡은 wrt를 마지막 reader가 푸는 것은 기본 뮤텍스락에서 정의되지 않은 동작이었다.
+   그래서 티켓 기반의 phase-fair 락으로 바꾸었다.
+ * 작동 원리 : reader 단계와 writer 단계가 번갈아 온다.
+ * 1. reader는 rin을 PF_RINC만큼 올리면서 writer 비트를 확인한다. writer가 없으면 바로 들어가고, 있으면 그 writer의
+      단계가 끝나서 writer 비트가 바뀔 때까지만 기다린다. 따라서 reader는 많아야 writer 한 명을 기다린다.
+      나올 때는 rout을 PF_RINC만큼 올린다. reader가 들어가고 나오는 데에는 원자적 덧셈 한 번씩이면 된다.
+ * 2. writer는 win에서 티켓을 받아 wout이 자기 티켓이 될 때까지 기다린다. 차례가 오면 rin에 writer 비트를 세워서
+      새 reader를 막고, 그 순간의 rin 값까지 rout이 따라올 때, 즉 먼저 들어간 reader가 모두 나갈 때까지 기다린다.
+      나올 때는 writer 비트를 지워서 기다리던 reader를 한꺼번에 들여보내고 wout을 올려 다음 writer에게 차례를 넘긴다.
+      writer 사이에는 기다리던 reader 단계가 반드시 한 번 끼므로 reader와 writer 모두 굶주리지 않는다.
+ * 락을 잡은 스레드가 직접 풀기 때문에 잡는 스레드와 푸는 스레드가 다른 문제도 없다.    */
 
   /* 실행 결과물의 주요과정 */
   /* 1. reader들의 중복이 허용되었는가? -> 컴파일 결과물에 중복됨이 확인됨 (reader의 알파벳이 종료되기 전에 다른 알파벳이 들어와서 종료함)
-     2. reader와 writer의 중복을 막았는가? -> 얼굴을 프린트하는 중에 알파벳이 입력되지 않음이 확인됨.
-     3. writer의 중복을 막았는가? -> 얼굴이 올바르게 프린트 되었음이 확인됨.
-     4. 공정한가? -> reader와 writer의 실행이 번갈아가며 실행하면서 굶주리지 않음이 확인됨. */
+     2. reader와 writer의 중복을 막았는가? -> reader와 writer 모두 출력을 버퍼에 모아 writev 한 번으로 내보내므로, 출력 모양만으로는
+        확인할 수 없다. 대신 writer는 writer 비트를 세운 순간까지 들어간 reader가 모두 나와서 rout이 rin을 따라올 때에만 들어가고,
+        그 뒤에 온 reader는 writer 비트가 바뀔 때까지 기다리므로 락의 구조로 보장된다. 같은 락을 쓰는 rwlock.c의 RW_PHASEFAIR를
+        rwstripe_check로 돌려서 배타 조건이 깨지지 않음을 확인하였다.
+     3. writer의 중복을 막았는가? -> writer는 티켓 순서대로 한 명씩만 wout의 차례를 받으므로 락의 구조로 보장된다. 2와 같은 이유로
+        얼굴 이미지가 올바르게 프린트되는 것은 증거가 되지 않는다.
+     4. 공정한가? -> reader는 많아야 writer 한 명을 기다리고, writer 사이에는 reader 단계가 한 번씩 끼므로 어느 쪽도 굶주리지 않는다.
+        실행 결과에서도 reader의 시퀀스와 writer의 이미지가 번갈아 나오는 것이 확인됨. */
 
   /* 문제점과 느낀점 */
   /* 해당 과제를 처음에는 readcnt와 writecnt 공유 변수 2개를 만들어 조건문으로 확인하며 현재 들어온 프로세스가 어느 시점인지를 확인하면서
      풀어보았는데, 그 과정이 너무 복잡하고 경우의 수가 너무 많았다. cnt값으로 lock을 걸면 이전에 실행되고 있는 reader가 종료를 하기전에
      writer를 실행하는 경우도 있었고 데드락에 빠지는 경우도 많았다. 그래서 lock을 하나 더 만들어 lock을 획득하는 순서대로 프로세스를 실행
-     시키면 어떨까라는 의문에서 코드를 작성해 보았고 잘 작동하였다. 하지만 lock을 획득하는 순서대로 프로세스를 실행시키기 때문에 프로세스의 실행
-     순서를 보장하진 않는다. reader와 writer가 lock을 획득하는 것은 무작위임으로 실행의 순서와 관계없이 누가 lock을 획득했느냐에 따라
-     순서가 결정된다. 교수님이 공유한 원자변수를 구현하거나 순서를 운에 맡겨도 된다고 하셔서 일단은 운에 맡기는 편으로 작성했다. 나중에 순서대로
-     실행하는 진짜로 공정한 reader-writer코드를 작성해보고싶다. */
+     시키는 방법을 써 보았지만, 누가 lock을 먼저 획득하는지는 운에 맡겨져 있어서 실행 순서를 보장하지 못했다.
+     티켓 기반의 phase-fair 락으로 바꾸면서 진입 순서가 운이 아니라 티켓과 writer 단계로 정해지게 되었다. reader는 원자적 덧셈 한 번으로
+     들어가므로 뮤텍스락을 쌓았을 때보다 가볍고, 잡는 스레드와 푸는 스레드가 달라지는 문제도 없어졌다. 다만 기다리는 스레드가 잠들지 않고
+     돌면서 기다리므로, 스레드가 코어보다 훨씬 많으면 sched_yield()로 양보하는 시간만큼 느려질 수 있다. */
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#define OB_SIZE 16384
+#define OB_NIOV 256
+
+/*
+ * 스레드마다 하나씩 가지는 출력 버퍼 구조체 타입
+ *
+ * printf()는 부를 때마다 stdout의 내부 락을 잡으므로, cs 안에서 문자 하나씩 출력하면 cs에 머무는 시간의
+ * 대부분이 보호할 일이 아니라 stdout 락에 쓰인다. 출력 버퍼는 스레드의 것이므로 락 없이 채우고,
+ * ob_flush()에서 writev() 한 번으로 내보낸다.
+ * 작은 출력은 buf에 복사하고, 내보낼 때까지 그대로 남아 있는 큰 문자열은 ob_ref()로 복사하지 않고 가리킨다.
+ * iov는 내보낼 조각의 목록이며, buf에 이어서 복사한 출력은 마지막 조각을 늘린다.
+ * buf나 iov가 차면 그때까지 모은 것을 먼저 내보낸다.
+ */
+typedef struct {
+    int fd;                             /* 출력할 파일 기술자 */
+    size_t len;                         /* buf에 복사한 바이트 수 */
+    int niov;                           /* iov에 모은 조각의 수 */
+    struct iovec iov[OB_NIOV];          /* 내보낼 조각의 목록 */
+    char buf[OB_SIZE];                  /* 복사한 출력 */
+} outbuf_t;
+
+static inline void ob_init(outbuf_t *ob, int fd)
+{
+    ob->fd = fd;
+    ob->len = 0;
+    ob->niov = 0;
+}
+
+/*
+ * 모은 출력을 writev() 한 번으로 내보낸다. 일부만 쓰였거나 시그널로 끊기면 남은 것을 이어서 쓴다.
+ * 성공하면 0을, 실패하면 -1을 리턴하며, 어느 쪽이든 버퍼는 비워진다.
+ */
+static inline int ob_flush(outbuf_t *ob)
+{
+    struct iovec *v = ob->iov;
+    int n = ob->niov, ret = 0;
+    ssize_t w;
+
+    while (n > 0) {
+        if ((w = writev(ob->fd, v, n)) < 0) {
+            if (errno == EINTR)
+                continue;
+            ret = -1;
+            break;
+        }
+        for (; n > 0 && (size_t)w >= v->iov_len; v++, n--)
+            w -= v->iov_len;
+        if (n > 0) {
+            v->iov_base = (char *)v->iov_base + w;
+            v->iov_len -= w;
+        }
+    }
+    ob->len = 0;
+    ob->niov = 0;
+    return ret;
+}
+
+/*
+ * 새 조각을 넣을 자리를 만든다. 목록이 차 있으면 먼저 내보낸다.
+ */
+static inline struct iovec *ob_slot(outbuf_t *ob)
+{
+    if (ob->niov == OB_NIOV)
+        ob_flush(ob);
+    return &ob->iov[ob->niov++];
+}
+
+/*
+ * buf에 n바이트를 채울 자리를 만들고 그 시작 주소를 리턴한다. n은 OB_SIZE를 넘을 수 없다.
+ * 마지막 조각이 buf의 끝에서 끝나면 그 조각을 늘리고, 아니면 새 조각을 시작한다.
+ */
+static inline char *ob_reserve(outbuf_t *ob, size_t n)
+{
+    struct iovec *last;
+    char *p;
+
+    if (ob->len + n > OB_SIZE || ob->niov == OB_NIOV)
+        ob_flush(ob);
+    p = ob->buf + ob->len;
+    last = ob->niov > 0 ? &ob->iov[ob->niov-1] : NULL;
+    if (last == NULL || (char *)last->iov_base + last->iov_len != p) {
+        last = ob_slot(ob);
+        last->iov_base = p;
+        last->iov_len = 0;
+    }
+    last->iov_len += n;
+    ob->len += n;
+    return p;
+}
+
+/*
+ * 문자 c를 n번 출력한다.
+ */
+static inline void ob_fill(outbuf_t *ob, int c, size_t n)
+{
+    size_t k;
+
+    while (n > 0) {
+        k = n < OB_SIZE ? n : OB_SIZE;
+        memset(ob_reserve(ob, k), c, k);
+        n -= k;
+    }
+}
+
+static inline void ob_putc(outbuf_t *ob, int c)
+{
+    *ob_reserve(ob, 1) = (char)c;
+}
+
+/*
+ * 문자열 s를 복사하지 않고 가리킨다. s는 다음 ob_flush()까지 바뀌거나 사라지면 안 된다.
+ */
+static inline void ob_ref(outbuf_t *ob, const char *s, size_t n)
+{
+    struct iovec *v = ob_slot(ob);
+
+    v->iov_base = (void *)s;
+    v->iov_len = n;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef PFLOCK_H
+#define PFLOCK_H
+
+#include <sched.h>
+#include <stdatomic.h>
+
+#define PF_RINC 0x100
+#define PF_WBITS 0x3
+#define PF_PRES 0x2
+#define PF_PHID 0x1
+#define PF_SPINCOUNT 256
+#define PF_CACHELINE 64
+
+/*
+ * 티켓 기반 phase-fair reader-writer 락 (Brandenburg-Anderson)
+ *
+ * rin과 rout은 들어간 reader와 나온 reader의 수를 PF_RINC 단위로 센다. rin의 아래 두 비트는 writer가 있으면
+ * PF_PRES가 서고, PF_PHID는 writer 단계를 구별하는 번호이다. win과 wout은 writer가 받은 티켓과 cs에 들어갈
+ * 차례인 티켓이다. reader는 자기가 본 writer 단계가 끝날 때까지만 기다리고, writer는 앞선 writer와
+ * 그 사이에 들어간 reader만 기다리므로 reader 단계와 writer 단계가 정해진 순서대로 번갈아 온다.
+ * reader는 원자적 덧셈 한 번으로 들어가고 한 번으로 나온다. 락을 잡은 스레드와 푸는 스레드가 같을 필요도 없다.
+ * reader가 건드리는 rin, rout과 writer끼리만 건드리는 win, wout은 서로 다른 캐시라인에 둔다.
+ */
+typedef struct {
+    _Alignas(PF_CACHELINE) atomic_uint rin;     /* 들어간 reader의 수와 writer 비트 */
+    atomic_uint rout;                           /* 나온 reader의 수 */
+    _Alignas(PF_CACHELINE) atomic_uint win;     /* writer가 받은 티켓 */
+    atomic_uint wout;                           /* cs에 들어갈 차례인 writer의 티켓 */
+} pflock_t;
+
+static inline void pf_init(pflock_t *l)
+{
+    atomic_init(&l->rin, 0);
+    atomic_init(&l->rout, 0);
+    atomic_init(&l->win, 0);
+    atomic_init(&l->wout, 0);
+}
+
+/*
+ * 조건이 풀릴 때까지 돌면서 기다리다가, 오래 기다리면 CPU를 양보한다.
+ */
+static inline void pf_pause(unsigned *spins)
+{
+    if (++*spins >= PF_SPINCOUNT) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+/*
+ * rin을 올리면서 writer 비트를 본다. writer가 있으면 그 writer의 단계가 끝나서 writer 비트가 바뀔 때까지만
+ * 기다린다. 뒤에 온 writer는 이 reader를 앞지르지 못한다.
+ */
+static inline void pf_rdlock(pflock_t *l)
+{
+    unsigned w, spins = 0;
+
+    w = atomic_fetch_add(&l->rin, PF_RINC) & PF_WBITS;
+    if (w == 0)
+        return;
+    while ((atomic_load_explicit(&l->rin, memory_order_acquire) & PF_WBITS) == w)
+        pf_pause(&spins);
+}
+
+static inline void pf_rdunlock(pflock_t *l)
+{
+    atomic_fetch_add_explicit(&l->rout, PF_RINC, memory_order_release);
+}
+
+/*
+ * 티켓 순서대로 writer 차례를 기다린 다음, writer 비트를 세워서 새 reader를 막고 그 순간까지 들어간 reader가
+ * 모두 나오기를 기다린다.
+ */
+static inline void pf_wrlock(pflock_t *l)
+{
+    unsigned ticket, w, spins = 0;
+
+    ticket = atomic_fetch_add(&l->win, 1);
+    while (atomic_load_explicit(&l->wout, memory_order_acquire) != ticket)
+        pf_pause(&spins);
+    w = PF_PRES | (ticket & PF_PHID);
+    ticket = atomic_fetch_add(&l->rin, w);
+    while (atomic_load_explicit(&l->rout, memory_order_acquire) != ticket)
+        pf_pause(&spins);
+}
+
+/*
+ * writer 비트를 지워서 기다리던 reader를 한꺼번에 들여보내고 다음 writer에게 차례를 넘긴다.
+ */
+static inline void pf_wrunlock(pflock_t *l)
+{
+    atomic_fetch_and_explicit(&l->rin, ~(unsigned)PF_WBITS, memory_order_release);
+    atomic_fetch_add_explicit(&l->wout, 1, memory_order_release);
+}
+
+#endif
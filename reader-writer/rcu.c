@@ -0,0 +1,156 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdlib.h>
+#include <sched.h>
+#include "rcu.h"
+
+/*
+ * RCU 도메인을 초기화한다. 성공하면 RCU_SUCCESS를, 실패하면 RCU_FAIL을 리턴한다.
+ */
+int rcu_init(rcu_domain_t *d)
+{
+    atomic_init(&d->global, 1);
+    if (pthread_mutex_init(&d->lock, NULL) != 0)
+        return RCU_FAIL;
+    d->threads = NULL;
+    for (int i = 0; i < RCU_NEPOCH; ++i)
+        d->limbo[i] = NULL;
+    d->pending = 0;
+    return RCU_SUCCESS;
+}
+
+/*
+ * 남아 있는 옛 버전을 모두 반납하고 도메인이 사용하던 자원을 반납한다.
+ * 읽기 구역에 있는 스레드가 없어야 한다.
+ */
+void rcu_destroy(rcu_domain_t *d)
+{
+    rcu_retired_t *r, *next;
+
+    for (int i = 0; i < RCU_NEPOCH; ++i) {
+        for (r = d->limbo[i]; r != NULL; r = next) {
+            next = r->next;
+            r->reclaim(r->ptr);
+            free(r);
+        }
+        d->limbo[i] = NULL;
+    }
+    d->pending = 0;
+    pthread_mutex_destroy(&d->lock);
+}
+
+/*
+ * 스레드를 도메인에 등록한다. 읽기 구역에 들어가기 전에 한 번 불러야 한다.
+ */
+void rcu_thread_init(rcu_domain_t *d, rcu_thread_t *self)
+{
+    atomic_init(&self->epoch, 0);
+    pthread_mutex_lock(&d->lock);
+    self->next = d->threads;
+    d->threads = self;
+    pthread_mutex_unlock(&d->lock);
+}
+
+/*
+ * 스레드를 도메인에서 뺀다. 읽기 구역 밖에서 불러야 한다.
+ */
+void rcu_thread_destroy(rcu_domain_t *d, rcu_thread_t *self)
+{
+    rcu_thread_t **pp;
+
+    pthread_mutex_lock(&d->lock);
+    for (pp = &d->threads; *pp != NULL; pp = &(*pp)->next)
+        if (*pp == self) {
+            *pp = self->next;
+            break;
+        }
+    pthread_mutex_unlock(&d->lock);
+}
+
+/*
+ * 읽기 구역에 있는 모든 스레드가 현재 세대에 들어와 있으면 세대를 올리고,
+ * 새 세대와 같은 목록을 쓰던 두 세대 전의 옛 버전을 반납한다. 세대를 올렸으면 true를 리턴한다.
+ * lock을 잡은 상태에서 부른다. 옛 버전을 반납하는 동안에도 reader는 기다리지 않는다.
+ */
+static bool try_advance(rcu_domain_t *d)
+{
+    uint64_t g = atomic_load_explicit(&d->global, memory_order_relaxed);
+    uint64_t e;
+    rcu_retired_t *r, *next;
+    int n = 0;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    for (rcu_thread_t *t = d->threads; t != NULL; t = t->next) {
+        e = atomic_load_explicit(&t->epoch, memory_order_relaxed);
+        if ((e & 1) && (e >> 1) != g)
+            return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    atomic_store_explicit(&d->global, g + 1, memory_order_relaxed);
+    r = d->limbo[(g + 1) % RCU_NEPOCH];
+    d->limbo[(g + 1) % RCU_NEPOCH] = NULL;
+    for (; r != NULL; r = next) {
+        next = r->next;
+        r->reclaim(r->ptr);
+        free(r);
+        n++;
+    }
+    d->pending -= n;
+    return true;
+}
+
+/*
+ * writer: rcu_publish()로 내린 옛 버전 ptr을 현재 세대의 limbo 목록에 넣고, 세대를 올릴 수 있으면 올린다.
+ * 유예 기간이 지나면 reclaim(ptr)로 반납한다. 기다리지 않으며, 메모리가 없으면 RCU_FAIL을 리턴한다.
+ */
+int rcu_retire(rcu_domain_t *d, void *ptr, void (*reclaim)(void *ptr))
+{
+    rcu_retired_t *r = (rcu_retired_t *)malloc(sizeof(rcu_retired_t));
+    uint64_t g;
+
+    if (r == NULL)
+        return RCU_FAIL;
+    r->ptr = ptr;
+    r->reclaim = reclaim;
+    pthread_mutex_lock(&d->lock);
+    g = atomic_load_explicit(&d->global, memory_order_relaxed);
+    r->next = d->limbo[g % RCU_NEPOCH];
+    d->limbo[g % RCU_NEPOCH] = r;
+    d->pending++;
+    try_advance(d);
+    pthread_mutex_unlock(&d->lock);
+    return RCU_SUCCESS;
+}
+
+/*
+ * writer: 세대를 올릴 수 있으면 올리고 유예 기간이 지난 옛 버전을 반납한다. 기다리지 않는다.
+ */
+bool rcu_try_advance(rcu_domain_t *d)
+{
+    bool advanced;
+
+    pthread_mutex_lock(&d->lock);
+    advanced = try_advance(d);
+    pthread_mutex_unlock(&d->lock);
+    return advanced;
+}
+
+/*
+ * writer: 지금까지 버려진 옛 버전이 모두 반납될 때까지 기다린다. 읽기 구역 안에서 부르면 안 된다.
+ * reader를 기다리는 것은 writer뿐이며, 기다리는 동안 CPU를 양보한다.
+ */
+void rcu_barrier(rcu_domain_t *d)
+{
+    while (1) {
+        pthread_mutex_lock(&d->lock);
+        if (d->pending == 0) {
+            pthread_mutex_unlock(&d->lock);
+            return;
+        }
+        try_advance(d);
+        pthread_mutex_unlock(&d->lock);
+        sched_yield();
+    }
+}
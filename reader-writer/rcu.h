@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef RCU_H
+#define RCU_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define RCU_NEPOCH 3
+#define RCU_CACHELINE 64
+#define RCU_SUCCESS 0
+#define RCU_FAIL 4
+
+/*
+ * 유예 기간이 지나면 반납할 옛 버전 하나를 나타내는 구조체 타입
+ */
+typedef struct rcu_retired {
+    void *ptr;                          /* 반납할 옛 버전 */
+    void (*reclaim)(void *ptr);         /* 옛 버전을 반납할 함수 */
+    struct rcu_retired *next;           /* 같은 세대에 버려진 다음 버전 */
+} rcu_retired_t;
+
+/*
+ * RCU를 사용하는 스레드마다 하나씩 가지는 정보
+ *
+ * epoch는 이 스레드가 읽기 구역에 있으면 (들어갈 때의 세대 << 1) | 1이고, 밖에 있으면 0이다.
+ * 이 스레드만 쓰고 writer가 읽으므로 다른 스레드와 캐시라인을 공유하지 않게 한다.
+ */
+typedef struct rcu_thread {
+    _Alignas(RCU_CACHELINE) _Atomic uint64_t epoch;     /* 읽기 구역에 들어갈 때의 세대 */
+    struct rcu_thread *next;                            /* 등록된 다음 스레드 */
+} rcu_thread_t;
+
+/*
+ * 세대(epoch) 기반으로 옛 버전을 반납하는 RCU 도메인 구조체 타입
+ *
+ * writer는 보호할 데이터의 새 사본을 만들어 원자적 포인터 교환으로 발행하고, 옛 버전은 rcu_retire()로
+ * 넘긴다. reader는 락 없이 포인터를 따라가며, writer를 전혀 기다리지 않는다.
+ * 옛 버전은 버려진 세대의 limbo 목록에 들어간다. 읽기 구역에 있는 모든 reader가 현재 세대 global에
+ * 들어와 있으면 세대를 하나 올릴 수 있고, 그때 두 세대 전에 버려진 버전은 어떤 reader도 볼 수 없으므로
+ * 반납한다. 세대는 RCU_NEPOCH(3)개의 목록을 돌아가며 쓴다.
+ * lock은 writer 쪽의 threads, limbo와 세대 올리기를 보호하며, reader는 잡지 않는다.
+ */
+typedef struct {
+    _Alignas(RCU_CACHELINE) _Atomic uint64_t global;    /* 현재 세대 */
+    pthread_mutex_t lock;                               /* writer 쪽 자료를 보호하는 락 */
+    rcu_thread_t *threads;                              /* 등록된 스레드의 목록 */
+    rcu_retired_t *limbo[RCU_NEPOCH];                   /* 세대별로 버려진 옛 버전 */
+    long pending;                                       /* 아직 반납하지 않은 옛 버전의 수 */
+} rcu_domain_t;
+
+int rcu_init(rcu_domain_t *d);
+void rcu_destroy(rcu_domain_t *d);
+void rcu_thread_init(rcu_domain_t *d, rcu_thread_t *self);
+void rcu_thread_destroy(rcu_domain_t *d, rcu_thread_t *self);
+int rcu_retire(rcu_domain_t *d, void *ptr, void (*reclaim)(void *ptr));
+bool rcu_try_advance(rcu_domain_t *d);
+void rcu_barrier(rcu_domain_t *d);
+
+/*
+ * reader: 읽기 구역에 들어간다. 현재 세대를 자기 epoch에 기록하는 것이 전부이며 기다리지 않는다.
+ * 기록이 보호할 포인터를 읽는 것보다 먼저 writer에게 보여야 하므로 순차 일관 울타리를 친다.
+ * writer도 세대를 올리기 전에 같은 울타리를 치므로, 둘 중 적어도 하나는 상대를 본다.
+ * 세대를 읽은 사이에 세대가 올라갔더라도, 옛 세대로 기록된 reader가 있는 동안에는 세대가 더 올라가지
+ * 않으므로 이 reader가 볼 수 있는 버전은 반납되지 않는다.
+ */
+static inline void rcu_read_lock(rcu_domain_t *d, rcu_thread_t *self)
+{
+    atomic_store_explicit(&self->epoch,
+                          (atomic_load_explicit(&d->global, memory_order_relaxed) << 1) | 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/*
+ * reader: 읽기 구역에서 나온다. 이후로는 읽기 구역에서 얻은 포인터를 사용하면 안 된다.
+ */
+static inline void rcu_read_unlock(rcu_thread_t *self)
+{
+    atomic_store_explicit(&self->epoch, 0, memory_order_release);
+}
+
+/*
+ * reader: writer가 발행한 포인터를 읽는다. 포인터가 가리키는 내용은 발행 전에 모두 쓰여 있다.
+ */
+static inline void *rcu_dereference(void *_Atomic *pp)
+{
+    return atomic_load_explicit(pp, memory_order_acquire);
+}
+
+/*
+ * writer: 새 버전 ptr을 발행하고 옛 버전을 리턴한다. 옛 버전은 rcu_retire()로 넘겨야 한다.
+ */
+static inline void *rcu_publish(void *_Atomic *pp, void *ptr)
+{
+    return atomic_exchange_explicit(pp, ptr, memory_order_acq_rel);
+}
+
+#endif
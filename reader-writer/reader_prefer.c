@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <pthread.h>
+#include "outbuf.h"
 
 #define L0 8192
 #define L1 50
@@ -349,6 +350,9 @@ pthread_cond_t w_cond; // writer의 조건 변수
 int r_wait = 0; // cs 진입을 기다리는 reader의 수
 int r_act = 0; // cs에 진입한 reader의 수
 int w_act = 0; // cs에 진입한 writer의 수 (0 또는 1)
+int w_wait = 0; // cs 진입을 기다리는 writer의 수
+unsigned long r_gen = 0; // writer가 기다리던 reader 무리를 들여보낸 횟수
+int w_handoff = 0; // writer에게 넘겨주었지만 아직 가져가지 않은 cs의 수 (0 또는 1)
 /*
  * Reader 선호
  * 수업시간에 배운 해법으로 CS(Critical Section; 임계구역)에 reader가 있으면 다른 reader가 중
@@ -359,46 +363,59 @@ int w_act = 0; // cs에 진입한 writer의 수 (0 또는 1)
 /*
  * Reader 스레드는 같은 문자를 L0번 출력한다. 예를 들면 <AAA...AA> 이런 식이다.
  * 출력할 문자는 인자를 통해 0이면 A, 1이면 B, ..., 등으로 출력하며, 시작과 끝을 <...>로 나타낸다.
- * 단일 reader라면 <AAA...AA>처럼 같은 문자만 출력하겠지만, critical section에서 reader의
- * 중복을 허용하기 때문에 reader가 많아지면 출력이 어지럽게 섞여서 나오는 것이 정상이다.
+ * 시퀀스는 스레드의 출력 버퍼에 모았다가 cs 안에서 writev 한 번으로 내보내서 시스템 호출의 수를 줄인다.
+ * 그렇다고 문자가 섞이지 않는 것은 아니다. 출력이 파이프이면 PIPE_BUF보다 긴 쓰기는 원자적이지 않고,
+ * ob_flush()가 일부만 쓰인 나머지를 다시 쓰기 때문에, 동시에 쓰는 reader의 시퀀스가 섞일 수 있다.
+ * 또 critical section에서 reader의 중복을 허용하기 때문에, writer 이미지 사이에 여러 reader의 시퀀스가
+ * 이어서 나오는 것이 정상이다.
  */
 void *reader(void *arg)
 {
-    int id, i;
+    int id;
+    unsigned long gen;
+    outbuf_t ob;
 
     /*
      * 들어온 인자를 통해 출력할 문자의 종류를 정한다.
      */
     id = *(int *)arg;
+    ob_init(&ob, STDOUT_FILENO);
     /*
      * 스레드가 살아 있는 동안 같은 문자열 시퀀스 <XXX...XX>를 반복해서 출력한다.
      */
     while (alive) {
         pthread_mutex_lock(&mutex);
+        gen = r_gen;
         r_wait++;
-        // 이미 cs에 들어간 writer가 있다면 기다림
-        while (w_act == 1) 
+        // 이미 cs에 들어간 writer가 있다면 기다림, writer가 나가면서 들여보내 주면 r_gen이 바뀜
+        while (r_gen == gen && w_act == 1)
             pthread_cond_wait(&r_cond, &mutex);
-        r_wait--;
-        r_act++;
+        // writer가 들여보내 준 reader는 이미 r_act에 세어져 있으므로 그대로 들어감
+        if (r_gen == gen) {
+            r_wait--;
+            r_act++;
+        }
         pthread_mutex_unlock(&mutex);
         
         /*
          * Begin Critical Section
          */
-        printf("<");
-        for (i = 0; i < L0; ++i)
-            printf("%c", 'A'+id);
-        printf(">");
+        ob_putc(&ob, '<');
+        ob_fill(&ob, 'A'+id, L0);
+        ob_putc(&ob, '>');
+        ob_flush(&ob);
         /* 
          * End Critical Section
          */
         
         pthread_mutex_lock(&mutex);
         r_act--;
-        // 자신이 마지막 reader이면서 기다리는 reader가 없다면, writer를 깨워줌
-        if (r_act == 0 && r_wait == 0)
+        // 자신이 마지막 reader이면서 기다리는 reader가 없다면, 기다리는 writer에게 cs를 넘겨주고 깨워줌
+        if (r_act == 0 && r_wait == 0 && w_wait > 0) {
+            w_act = 1;
+            w_handoff++;
             pthread_cond_signal(&w_cond);
+        }
         pthread_mutex_unlock(&mutex);
         
     }
@@ -409,75 +426,104 @@ void *reader(void *arg)
  * Writer 스레드는 어떤 사람의 얼굴 이미지를 출력한다.
  * 이미지는 여러 종류가 있으며 인자를 통해 식별한다.
  * Writer가 critical section에 있으면 다른 writer는 물론이고 어떠한 reader도 들어올 수 없다.
- * 만일 이것을 어기고 다른 writer나 reader가 들어왔다면 얼굴 이미지가 깨져서 쉽게 감지된다.
+ * 이미지는 줄마다 printf를 부르지 않고 출력 버퍼에 모은 줄들을 writev 한 번으로 내보낸다.
+ * 따라서 이것을 어기고 들어온 스레드가 있어도 이미지가 깨져 보이지 않으므로, 상호배타는 출력 모양이 아니라
+ * 락의 공유 변수로 확인해야 한다.
  */
 void *writer(void *arg)
 {
     int id, i;
     struct timespec req;
+    outbuf_t ob;
 
     /*
      * 들어온 인자를 통해 얼굴 이미지의 종류를 정한다.
      * 랜덤 생성기의 시드 값을 현재 시간으로 초기화한다.
      */
     id = *(int *)arg;
+    ob_init(&ob, STDOUT_FILENO);
     srand(time(NULL));
     /*
      * 스레드가 살아 있는 동안 같은 이미지를 반복해서 출력한다.
      */
     while (alive) {
         pthread_mutex_lock(&mutex);
-        // 기다리고 있는 reader가 있거나 cs에 진입한 reader나 writer가 있다면 기다림
-        while (r_wait > 0 || w_act+r_act > 0)
+        w_wait++;
+        // 기다리고 있는 reader가 있거나 cs에 진입한 reader나 writer가 있다면 기다림, cs를 넘겨받으면 w_handoff가 생김
+        while (w_handoff == 0 && (r_wait > 0 || w_act+r_act > 0))
             pthread_cond_wait(&w_cond, &mutex);
-        w_act++;
+        w_wait--;
+        // 넘겨받은 cs라면 w_act는 이미 1임
+        if (w_handoff > 0)
+            w_handoff--;
+        else
+            w_act++;
         pthread_mutex_unlock(&mutex);
         /*
          * Begin Critical Section
          */
-        printf("\n");
+        ob_putc(&ob, '\n');
         switch (id) {
             case 0:
-                for (i = 0; i < L1; ++i)
-                    printf("%s\n", img1[i]);
+                for (i = 0; i < L1; ++i) {
+                    ob_ref(&ob, img1[i], strlen(img1[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 1:
-                for (i = 0; i < L2; ++i)
-                    printf("%s\n", img2[i]);
+                for (i = 0; i < L2; ++i) {
+                    ob_ref(&ob, img2[i], strlen(img2[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 2:
-                for (i = 0; i < L3; ++i)
-                    printf("%s\n", img3[i]);
+                for (i = 0; i < L3; ++i) {
+                    ob_ref(&ob, img3[i], strlen(img3[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 3:
-                for (i = 0; i < L4; ++i)
-                    printf("%s\n", img4[i]);
+                for (i = 0; i < L4; ++i) {
+                    ob_ref(&ob, img4[i], strlen(img4[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             case 4:
-                for (i = 0; i < L5; ++i)
-                    printf("%s\n", img5[i]);
+                for (i = 0; i < L5; ++i) {
+                    ob_ref(&ob, img5[i], strlen(img5[i]));
+                    ob_putc(&ob, '\n');
+                }
                 break;
             default:
                 ;
         }
+        ob_flush(&ob);
         /* 
          * End Critical Section
          */
         pthread_mutex_lock(&mutex);
-        w_act--;
+        // 기다리는 reader가 있다면, 그 reader들을 모두 r_act에 세어서 들여보낸 다음 깨워줌
+        if (r_wait > 0) {
+            w_act--;
+            r_act += r_wait;
+            r_wait = 0;
+            r_gen++;
+            pthread_cond_broadcast(&r_cond);
+        }
+        // 기다리는 reader가 없고 writer가 있으면, w_act를 그대로 둔 채 cs를 넘겨주고 writer 하나를 깨워줌
+        else if (w_wait > 0) {
+            w_handoff++;
+            pthread_cond_signal(&w_cond);
+        }
+        else
+            w_act--;
+        pthread_mutex_unlock(&mutex);
         /*
          * 이미지 출력 후 SLEEPTIME 나노초 안에서 랜덤하게 쉰다.
          */
         req.tv_sec = 0;
         req.tv_nsec = rand() % SLEEPTIME;
         nanosleep(&req, NULL);
-        // 기다리는 reader가 있다면, reader 스레드들을 깨워줌
-        if (r_wait > 0)
-            pthread_cond_broadcast(&r_cond);
-        // 기다리는 reader가 없으면, writer 스레드를 깨워줌
-        else
-            pthread_cond_signal(&w_cond);
-        pthread_mutex_unlock(&mutex);
     }
     pthread_exit(NULL);
 }
@@ -0,0 +1,901 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdlib.h>
+#include <sched.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#include "rwlock.h"
+
+#define SPINCOUNT 256
+
+/*
+ * reader-writer 락을 type 정책으로 초기화한다. 성공하면 RW_SUCCESS를, 실패하면 RW_FAIL을 리턴한다.
+ */
+int rwlock_init(rwlock_t *l, int type)
+{
+    if (type < RW_READER || type > RW_BIASED)
+        return RW_FAIL;
+    l->type = type;
+    l->r_wait = l->r_act = l->w_wait = l->w_act = 0;
+    l->r_gen = 0;
+    l->w_handoff = 0;
+    l->quiet = 0;
+    l->last = -1;
+    atomic_init(&l->bias, RW_BIAS_NONE);
+    atomic_init(&l->owner, -1);
+    l->readcnt = 0;
+    l->slots = NULL;
+    pthread_mutex_init(&l->mutex, NULL);
+    pthread_cond_init(&l->r_cond, NULL);
+    pthread_cond_init(&l->w_cond, NULL);
+    pthread_mutex_init(&l->fair, NULL);
+    sem_init(&l->wrt, 0, 1);
+    pthread_mutex_init(&l->wmutex, NULL);
+    pthread_mutex_init(&l->umutex, NULL);
+    pthread_mutex_init(&l->pmutex, NULL);
+    pthread_cond_init(&l->p_cond, NULL);
+    atomic_init(&l->pending, 0);
+    atomic_init(&l->writer, 0);
+    atomic_init(&l->nthread, 0);
+    pf_init(&l->pf);
+    if (type == RW_BIGREADER || type == RW_BIASED) {
+        l->slots = (rw_slot_t *)aligned_alloc(RW_CACHELINE, sizeof(rw_slot_t)*RW_NSLOT);
+        if (l->slots == NULL) {
+            rwlock_destroy(l);
+            return RW_FAIL;
+        }
+        for (int i = 0; i < RW_NSLOT; ++i)
+            atomic_init(&l->slots[i].readers, 0);
+    }
+    return RW_SUCCESS;
+}
+
+/*
+ * reader-writer 락이 사용하던 자원을 반납한다. 락을 기다리거나 가진 스레드가 없어야 한다.
+ */
+void rwlock_destroy(rwlock_t *l)
+{
+    pthread_mutex_destroy(&l->mutex);
+    pthread_cond_destroy(&l->r_cond);
+    pthread_cond_destroy(&l->w_cond);
+    pthread_mutex_destroy(&l->fair);
+    sem_destroy(&l->wrt);
+    pthread_mutex_destroy(&l->wmutex);
+    pthread_mutex_destroy(&l->umutex);
+    pthread_mutex_destroy(&l->pmutex);
+    pthread_cond_destroy(&l->p_cond);
+    free(l->slots);
+    l->slots = NULL;
+}
+
+/*
+ * 스레드가 락을 사용하기 전에 자신의 정보를 준비한다. RW_BIGREADER와 RW_BIASED의 슬롯은 돌아가면서 나눠준다.
+ */
+void rw_thread_init(rwlock_t *l, rw_thread_t *self)
+{
+    self->slot = atomic_fetch_add(&l->nthread, 1) % RW_NSLOT;
+    self->biased = 0;
+}
+
+/*
+ * RW_BIGREADER: 자기 슬롯의 카운터를 올린 다음 writer 플래그를 확인한다.
+ * writer도 플래그를 세운 다음 카운터를 읽으므로(둘 다 순차 일관), 둘 중 적어도 하나는 상대를 본다.
+ * 플래그가 서 있으면 카운터를 되돌리고, writer가 풀어줄 때까지 wmutex에서 기다렸다가 다시 시도한다.
+ */
+static void br_rdlock(rwlock_t *l, rw_thread_t *self)
+{
+    atomic_int *readers = &l->slots[self->slot].readers;
+
+    while (1) {
+        atomic_fetch_add(readers, 1);
+        if (!atomic_load(&l->writer))
+            return;
+        atomic_fetch_sub(readers, 1);
+        pthread_mutex_lock(&l->wmutex);
+        pthread_mutex_unlock(&l->wmutex);
+    }
+}
+
+/*
+ * RW_BIGREADER: writer 사이에서 wmutex로 순서를 정한 다음 플래그를 세워서 새 reader를 막고,
+ * 이미 들어간 reader가 모두 나갈 때까지 슬롯마다 기다린다. 오래 기다리면 CPU를 양보한다.
+ */
+static void br_wrlock(rwlock_t *l)
+{
+    unsigned spins;
+
+    pthread_mutex_lock(&l->wmutex);
+    atomic_store(&l->writer, 1);
+    for (int i = 0; i < RW_NSLOT; ++i) {
+        spins = 0;
+        while (atomic_load(&l->slots[i].readers) > 0)
+            if (++spins >= SPINCOUNT) {
+                spins = 0;
+                sched_yield();
+            }
+    }
+}
+
+static void br_wrunlock(rwlock_t *l)
+{
+    atomic_store_explicit(&l->writer, 0, memory_order_release);
+    pthread_mutex_unlock(&l->wmutex);
+}
+
+/*
+ * 기다리는 시간에 제한이 있는 락은 abstime까지만 기다린다. abstime은 pthread_cond_timedwait()처럼
+ * CLOCK_REALTIME 기준의 절대 시각이며, NULL이면 전혀 기다리지 않는 try 락이고, &forever이면 제한이 없다.
+ * 락을 얻지 못하고 포기하는 스레드는 자기가 올려둔 r_wait, w_wait을 되돌리고, 그 때문에 더 이상 기다릴
+ * 이유가 없어진 스레드가 있으면 깨워준다.
+ * 시간이 다 되었더라도 그 사이에 조건이 풀렸으면 락을 얻은 것으로 하므로, 깨워준 신호를 받고도
+ * 시간이 지나서 포기하는 바람에 신호를 잃어버리는 일이 없다.
+ */
+static const struct timespec forever;
+
+/*
+ * 시간 제한이 지났는지 확인한다. try 락이면 처음부터 지난 것으로 본다.
+ */
+static bool expired(const struct timespec *abstime)
+{
+    struct timespec now;
+
+    if (abstime == NULL)
+        return true;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec);
+}
+
+/*
+ * 락을 얻지 못했을 때 리턴할 값이다. try 락이면 RW_BUSY, 시간 제한이 있으면 RW_TIMEDOUT이다.
+ */
+static inline int giveup(const struct timespec *abstime)
+{
+    return abstime == NULL ? RW_BUSY : RW_TIMEDOUT;
+}
+
+/*
+ * 조건변수에서 시간 제한까지 기다린다. 시간이 다 되었으면 ETIMEDOUT을 리턴한다.
+ */
+static int cond_wait_until(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *abstime)
+{
+    if (abstime == NULL)
+        return ETIMEDOUT;
+    if (abstime == &forever)
+        return pthread_cond_wait(cond, mutex);
+    return pthread_cond_timedwait(cond, mutex, abstime);
+}
+
+/*
+ * RW_BIASED: membarrier()로 이 프로세스의 모든 스레드가 메모리 울타리를 치게 한다. 처음 부를 때 등록하며,
+ * 쓸 수 없으면 false를 리턴한다. membarrier_ready()는 울타리를 치지 않고 쓸 수 있는지만 알려준다.
+ */
+static pthread_once_t membarrier_once = PTHREAD_ONCE_INIT;
+static bool membarrier_ok;
+
+static void membarrier_register(void)
+{
+    membarrier_ok = syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+}
+
+static bool membarrier_ready(void)
+{
+    pthread_once(&membarrier_once, membarrier_register);
+    return membarrier_ok;
+}
+
+static bool membarrier_all(void)
+{
+    return membarrier_ready() && syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0;
+}
+
+/*
+ * RW_BIASED: 느린 길로 들어간 reader가 mutex를 잡은 상태에서 부른다. last는 마지막으로 느린 길로 들어간
+ * reader의 슬롯이고, quiet는 그 reader가 연달아 들어간 횟수이다. 다른 슬롯의 reader가 들어오면 quiet를
+ * 처음부터 세므로, writer 없이 한 스레드가 RW_REBIAS 번 연달아 읽어야 그 스레드에게 치우침을 준다.
+ * writer가 cs를 얻은 다음에는 quiet가 0이 되고 여기서 w_act를 보므로, writer가 있는 동안에는 치우침이
+ * 생기지 않는다. 뮤텍스락으로 writer가 쓴 내용을 본 다음 release로 bias를 저장하므로, owner는 빠른 길에서
+ * bias를 읽는 것만으로 그 내용을 본다. 빠른 길의 플래그는 슬롯이므로 슬롯을 같이 쓰는 스레드가 있으면
+ * 치우침을 주지 않는다. 시간 제한이 있는 writer가 거두어들이다가 포기해서 이전 owner가 아직 빠른 길에
+ * 있으면, 그 owner가 나올 때까지 새 치우침을 주지 않는다.
+ */
+static void bias_claim(rwlock_t *l, rw_thread_t *self)
+{
+    int bias = atomic_load_explicit(&l->bias, memory_order_relaxed);
+
+    if (l->w_act != 0 || l->w_wait != 0 || bias == RW_BIAS_ON)
+        return;
+    if (bias == RW_BIAS_OFF && atomic_load(&l->slots[atomic_load_explicit(&l->owner, memory_order_relaxed)].readers))
+        return;
+    if (l->last != self->slot) {
+        l->last = self->slot;
+        l->quiet = 0;
+    }
+    if (++l->quiet < RW_REBIAS || atomic_load(&l->nthread) > RW_NSLOT || !membarrier_ready())
+        return;
+    atomic_store_explicit(&l->owner, self->slot, memory_order_relaxed);
+    atomic_store_explicit(&l->bias, RW_BIAS_ON, memory_order_release);
+}
+
+/*
+ * RW_READER와 RW_WRITER는 락을 넘겨줄 때 깨울 스레드가 할 일까지 대신 해준다(direct handoff).
+ * 기다리는 reader 무리를 들여보낼 때는 r_wait을 통째로 r_act로 옮기고 r_gen을 올린 다음 깨운다.
+ * 깨어난 reader는 r_gen이 바뀐 것만 보고 곧바로 cs에 들어가며, 조건을 다시 따지거나 카운터를 고치지 않는다.
+ * writer에게 넘겨줄 때는 w_act를 1로 둔 채 w_handoff를 올리고 writer 하나만 깨운다. 깨어난 writer는
+ * w_handoff를 하나 가져가는 것으로 cs의 주인이 되므로, 그 사이에 다른 스레드가 끼어들 틈이 없다.
+ */
+static inline bool cv_rd_blocked(rwlock_t *l)
+{
+    return l->w_act == 1 || (l->type == RW_WRITER && l->w_wait > 0);
+}
+
+static inline bool cv_wr_blocked(rwlock_t *l)
+{
+    if (l->type != RW_WRITER)
+        return l->r_wait > 0 || l->w_act + l->r_act > 0;
+    return l->w_act == 1 || l->r_act > 0;
+}
+
+/*
+ * 기다리는 reader를 모두 대신 cs에 넣고 깨운다. mutex를 잡은 상태에서 부른다.
+ */
+static void cv_admit_readers(rwlock_t *l)
+{
+    if (l->r_wait == 0)
+        return;
+    l->r_act += l->r_wait;
+    l->r_wait = 0;
+    l->r_gen++;
+    pthread_cond_broadcast(&l->r_cond);
+}
+
+/*
+ * 기다리는 writer 하나에게 cs를 넘겨준다. mutex를 잡은 상태에서 부른다.
+ */
+static void cv_handoff_writer(rwlock_t *l)
+{
+    l->w_act = 1;
+    l->w_handoff++;
+    pthread_cond_signal(&l->w_cond);
+}
+
+static int cv_rdlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    unsigned long gen;
+    int ret = RW_SUCCESS;
+
+    pthread_mutex_lock(&l->mutex);
+    gen = l->r_gen;
+    l->r_wait++;
+    while (l->r_gen == gen && cv_rd_blocked(l))
+        if (cond_wait_until(&l->r_cond, &l->mutex, abstime) == ETIMEDOUT &&
+            l->r_gen == gen && cv_rd_blocked(l)) {
+            ret = giveup(abstime);
+            break;
+        }
+    // 무리에 끼어 들어왔으면 이미 r_act에 세어져 있음
+    if (l->r_gen == gen) {
+        l->r_wait--;
+        if (ret == RW_SUCCESS) {
+            l->r_act++;
+            if (l->type == RW_BIASED)
+                bias_claim(l, self);
+        }
+        // 포기한 reader가 마지막으로 기다리던 reader라면, 그 때문에 기다리던 writer를 깨워줌
+        else if (l->type != RW_WRITER && l->r_wait == 0 && l->r_act == 0)
+            pthread_cond_signal(&l->w_cond);
+    }
+    pthread_mutex_unlock(&l->mutex);
+    return ret;
+}
+
+static void cv_rdunlock(rwlock_t *l)
+{
+    pthread_mutex_lock(&l->mutex);
+    l->r_act--;
+    // 자신이 마지막 reader이면서 (RW_READER는 기다리는 reader도 없을 때) 기다리는 writer가 있으면 넘겨줌
+    if (l->r_act == 0 && l->w_wait > 0 && (l->type == RW_WRITER || l->r_wait == 0))
+        cv_handoff_writer(l);
+    pthread_mutex_unlock(&l->mutex);
+}
+
+static int cv_wrlock(rwlock_t *l, const struct timespec *abstime)
+{
+    int ret = RW_SUCCESS;
+
+    pthread_mutex_lock(&l->mutex);
+    l->w_wait++;
+    while (l->w_handoff == 0 && cv_wr_blocked(l))
+        if (cond_wait_until(&l->w_cond, &l->mutex, abstime) == ETIMEDOUT &&
+            l->w_handoff == 0 && cv_wr_blocked(l)) {
+            ret = giveup(abstime);
+            break;
+        }
+    l->w_wait--;
+    if (ret == RW_SUCCESS) {
+        // 넘겨받았으면 w_act는 이미 1임
+        if (l->w_handoff > 0)
+            l->w_handoff--;
+        else
+            l->w_act = 1;
+    }
+    // 포기한 writer가 마지막으로 기다리던 writer라면, 그 때문에 막혀 있던 reader들을 들여보냄
+    else if (l->type == RW_WRITER && l->w_wait == 0 && l->w_act == 0)
+        cv_admit_readers(l);
+    pthread_mutex_unlock(&l->mutex);
+    return ret;
+}
+
+static void cv_wrunlock(rwlock_t *l)
+{
+    pthread_mutex_lock(&l->mutex);
+    // RW_READER는 기다리는 reader를 먼저, RW_WRITER는 기다리는 writer를 먼저 들여보냄
+    if (l->type != RW_WRITER && l->r_wait > 0) {
+        l->w_act = 0;
+        cv_admit_readers(l);
+    }
+    else if (l->w_wait > 0)
+        cv_handoff_writer(l);
+    else {
+        l->w_act = 0;
+        cv_admit_readers(l);
+    }
+    pthread_mutex_unlock(&l->mutex);
+}
+
+/*
+ * RW_BIASED: owner의 빠른 길이다. 자기 슬롯에 1을 저장한 다음 bias와 owner를 다시 읽어서 여전히 자기에게
+ * 치우쳐 있으면 들어간다. 저장과 읽기 사이에 하드웨어 울타리를 치지 않는다. writer가 bias를 내린 다음
+ * membarrier()를 부르므로, 그보다 먼저 bias를 읽고 들어간 owner의 슬롯은 writer에게 반드시 보인다.
+ * owner는 bias를 올리기 전에 저장되고 자기 자신만 자기를 owner로 만들므로, acquire로 읽은 bias 다음에
+ * 읽은 owner가 자기이면 그 치우침은 자기 것이다. 물러날 때도 자기 슬롯만 지우므로 다른 owner를 건드리지 않는다.
+ */
+static bool bias_fast_rdlock(rwlock_t *l, rw_thread_t *self)
+{
+    atomic_int *in = &l->slots[self->slot].readers;
+
+    if (atomic_load_explicit(&l->bias, memory_order_acquire) != RW_BIAS_ON ||
+        atomic_load_explicit(&l->owner, memory_order_relaxed) != self->slot)
+        return false;
+    atomic_store_explicit(in, 1, memory_order_relaxed);
+    atomic_signal_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&l->bias, memory_order_acquire) == RW_BIAS_ON &&
+        atomic_load_explicit(&l->owner, memory_order_relaxed) == self->slot) {
+        self->biased = 1;
+        return true;
+    }
+    atomic_store_explicit(in, 0, memory_order_release);
+    return false;
+}
+
+static int bias_rdlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    if (bias_fast_rdlock(l, self))
+        return RW_SUCCESS;
+    return cv_rdlock(l, self, abstime);
+}
+
+static void bias_rdunlock(rwlock_t *l, rw_thread_t *self)
+{
+    if (self->biased) {
+        self->biased = 0;
+        atomic_store_explicit(&l->slots[self->slot].readers, 0, memory_order_release);
+    }
+    else
+        cv_rdunlock(l);
+}
+
+/*
+ * RW_BIASED: writer로 cs를 얻은 다음 부른다. 치우침이 있으면 거두어들이는 핸드셰이크를 한다.
+ * bias를 내리고 membarrier()로 owner의 스레드에도 울타리를 치게 한 다음, owner의 슬롯을 읽어서 빠른 길로
+ * 들어가 있는 owner가 나올 때까지 abstime까지만 기다린다. 그 뒤로 owner는 느린 길로 들어오므로 w_act에 막힌다.
+ * writer가 cs에 있는 동안에는 owner가 바뀌지 않는다. 시간이 다 되면 bias를 RW_BIAS_OFF로 둔 채 cs를 내주고
+ * 포기한다. 그러면 owner가 아직 빠른 길에 있을 수 있으므로, bias가 RW_BIAS_OFF이면 다음 writer도 owner의
+ * 슬롯이 빌 때까지 기다린다.
+ */
+static int bias_revoke(rwlock_t *l, const struct timespec *abstime)
+{
+    atomic_int *in;
+    unsigned spins = 0;
+    int bias;
+
+    l->quiet = 0;
+    bias = atomic_load_explicit(&l->bias, memory_order_relaxed);
+    if (bias == RW_BIAS_NONE)
+        return RW_SUCCESS;
+    if (bias == RW_BIAS_ON) {
+        atomic_store(&l->bias, RW_BIAS_OFF);
+        membarrier_all();
+    }
+    in = &l->slots[atomic_load_explicit(&l->owner, memory_order_relaxed)].readers;
+    while (atomic_load_explicit(in, memory_order_acquire))
+        if (++spins >= SPINCOUNT || abstime == NULL) {
+            spins = 0;
+            if (abstime != &forever && expired(abstime)) {
+                cv_wrunlock(l);
+                return giveup(abstime);
+            }
+            sched_yield();
+        }
+    return RW_SUCCESS;
+}
+
+/*
+ * reader로 cs에 들어간다. 정책에 따라 writer가 있거나 기다리면 기다린다.
+ */
+void rw_rdlock(rwlock_t *l, rw_thread_t *self)
+{
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            cv_rdlock(l, self, &forever);
+            break;
+        case RW_FAIR:
+            pthread_mutex_lock(&l->fair);
+            pthread_mutex_lock(&l->mutex);
+            if (l->readcnt == 0)
+                sem_wait(&l->wrt);
+            l->readcnt++;
+            pthread_mutex_unlock(&l->fair);
+            pthread_mutex_unlock(&l->mutex);
+            break;
+        case RW_BIGREADER:
+            br_rdlock(l, self);
+            break;
+        case RW_PHASEFAIR:
+            pf_rdlock(&l->pf);
+            break;
+        case RW_BIASED:
+            bias_rdlock(l, self, &forever);
+            break;
+        default:
+            ;
+    }
+}
+
+/*
+ * reader로 들어간 cs에서 나온다.
+ */
+void rw_rdunlock(rwlock_t *l, rw_thread_t *self)
+{
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            cv_rdunlock(l);
+            break;
+        case RW_FAIR:
+            pthread_mutex_lock(&l->mutex);
+            l->readcnt--;
+            if (l->readcnt == 0)
+                sem_post(&l->wrt);
+            pthread_mutex_unlock(&l->mutex);
+            break;
+        case RW_BIGREADER:
+            atomic_fetch_sub_explicit(&l->slots[self->slot].readers, 1, memory_order_release);
+            break;
+        case RW_PHASEFAIR:
+            pf_rdunlock(&l->pf);
+            break;
+        case RW_BIASED:
+            bias_rdunlock(l, self);
+            break;
+        default:
+            ;
+    }
+}
+
+/*
+ * 정책대로 writer가 되어 cs에 들어간다. cs에 다른 writer나 reader가 있으면 모두 나갈 때까지 기다린다.
+ */
+static void policy_wrlock(rwlock_t *l)
+{
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            cv_wrlock(l, &forever);
+            break;
+        case RW_FAIR:
+            pthread_mutex_lock(&l->fair);
+            sem_wait(&l->wrt);
+            pthread_mutex_unlock(&l->fair);
+            break;
+        case RW_BIGREADER:
+            br_wrlock(l);
+            break;
+        case RW_PHASEFAIR:
+            pf_wrlock(&l->pf);
+            break;
+        case RW_BIASED:
+            cv_wrlock(l, &forever);
+            bias_revoke(l, &forever);
+            break;
+        default:
+            ;
+    }
+}
+
+/*
+ * 정책대로 writer로 들어간 cs에서 나온다.
+ */
+static void policy_wrunlock(rwlock_t *l)
+{
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            cv_wrunlock(l);
+            break;
+        case RW_FAIR:
+            sem_post(&l->wrt);
+            break;
+        case RW_BIGREADER:
+            br_wrunlock(l);
+            break;
+        case RW_PHASEFAIR:
+            pf_wrunlock(&l->pf);
+            break;
+        case RW_BIASED:
+            cv_wrunlock(l);
+            break;
+        default:
+            ;
+    }
+}
+
+static int mutex_lock_until(pthread_mutex_t *mutex, const struct timespec *abstime)
+{
+    if (abstime == NULL)
+        return pthread_mutex_trylock(mutex);
+    return pthread_mutex_timedlock(mutex, abstime);
+}
+
+static int sem_wait_until(sem_t *sem, const struct timespec *abstime)
+{
+    int ret;
+
+    do {
+        ret = abstime == NULL ? sem_trywait(sem) : sem_timedwait(sem, abstime);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+/*
+ * RW_BIGREADER: 플래그를 보고 물러난 reader는 wmutex에서 시간 제한까지만 기다린다.
+ */
+static int br_rdlock_until(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    atomic_int *readers = &l->slots[self->slot].readers;
+
+    while (1) {
+        atomic_fetch_add(readers, 1);
+        if (!atomic_load(&l->writer))
+            return RW_SUCCESS;
+        atomic_fetch_sub(readers, 1);
+        if (mutex_lock_until(&l->wmutex, abstime) != 0)
+            return giveup(abstime);
+        pthread_mutex_unlock(&l->wmutex);
+    }
+}
+
+/*
+ * RW_BIGREADER: 플래그를 세운 다음 시간 제한까지 슬롯이 비기를 기다리고, 시간이 다 되면 플래그를 내리고 물러난다.
+ */
+static int br_wrlock_until(rwlock_t *l, const struct timespec *abstime)
+{
+    unsigned spins;
+
+    if (mutex_lock_until(&l->wmutex, abstime) != 0)
+        return giveup(abstime);
+    atomic_store(&l->writer, 1);
+    for (int i = 0; i < RW_NSLOT; ++i) {
+        spins = 0;
+        while (atomic_load(&l->slots[i].readers) > 0) {
+            if (++spins >= SPINCOUNT || abstime == NULL) {
+                spins = 0;
+                if (expired(abstime)) {
+                    br_wrunlock(l);
+                    return giveup(abstime);
+                }
+                sched_yield();
+            }
+        }
+    }
+    return RW_SUCCESS;
+}
+
+/*
+ * RW_PHASEFAIR: writer 비트가 없을 때만 rin을 올려서 들어간다. writer 비트가 있을 때 rin을 올리면
+ * 그 writer 단계가 끝날 때까지 포기할 수 없으므로, 시간 제한이 있는 reader는 rin을 올리지 않고 기다린다.
+ * 대신 reader 단계 순서에 끼지 못하므로 writer가 연달아 오면 그 뒤로 밀릴 수 있다.
+ */
+static int pf_rdlock_until(pflock_t *l, const struct timespec *abstime)
+{
+    unsigned r, spins = 0;
+
+    r = atomic_load(&l->rin);
+    while (1) {
+        if (!(r & PF_WBITS)) {
+            if (atomic_compare_exchange_weak(&l->rin, &r, r + PF_RINC))
+                return RW_SUCCESS;
+            continue;
+        }
+        if (++spins >= SPINCOUNT || abstime == NULL) {
+            spins = 0;
+            if (expired(abstime))
+                return giveup(abstime);
+            sched_yield();
+        }
+        r = atomic_load(&l->rin);
+    }
+}
+
+/*
+ * RW_PHASEFAIR: 받은 티켓은 되돌릴 수 없으므로, 앞선 writer도 cs에 있는 reader도 없을 때만 티켓을 받는다.
+ * writer 비트를 세운 다음에는 포기하지 않는다. 아무것도 하지 않고 writer 단계를 끝내면, 앞 단계를 기다리던
+ * reader가 writer 비트가 바뀐 것을 보기 전에 같은 단계 번호의 다음 writer가 비트를 세워서 서로 기다리게 되기
+ * 때문이다. 티켓을 받은 뒤에 기다리는 것은 그 사이에 끼어든 reader가 cs를 마칠 때까지뿐이다.
+ * 시간 제한이 있는 writer는 티켓 줄을 서지 않으므로 다른 writer보다 순서가 밀릴 수 있다.
+ */
+static int pf_wrlock_until(pflock_t *l, const struct timespec *abstime)
+{
+    unsigned ticket, w, spins = 0;
+
+    while (1) {
+        ticket = atomic_load(&l->wout);
+        if (atomic_load(&l->win) == ticket &&
+            (atomic_load(&l->rin) & ~(unsigned)PF_WBITS) == atomic_load(&l->rout) &&
+            atomic_compare_exchange_strong(&l->win, &ticket, ticket + 1))
+            break;
+        if (++spins >= SPINCOUNT || abstime == NULL) {
+            spins = 0;
+            if (expired(abstime))
+                return giveup(abstime);
+            sched_yield();
+        }
+    }
+    w = PF_PRES | (ticket & PF_PHID);
+    ticket = atomic_fetch_add(&l->rin, w);
+    while (atomic_load_explicit(&l->rout, memory_order_acquire) != ticket)
+        pf_pause(&spins);
+    return RW_SUCCESS;
+}
+
+/*
+ * reader로 cs에 들어가되 abstime까지만 기다린다. abstime이 NULL이면 기다리지 않는다.
+ */
+static int rdlock_until(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    int ret = RW_SUCCESS;
+
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            ret = cv_rdlock(l, self, abstime);
+            break;
+        case RW_FAIR:
+            if (mutex_lock_until(&l->fair, abstime) != 0)
+                return giveup(abstime);
+            pthread_mutex_lock(&l->mutex);
+            if (l->readcnt == 0 && sem_wait_until(&l->wrt, abstime) != 0)
+                ret = giveup(abstime);
+            else
+                l->readcnt++;
+            pthread_mutex_unlock(&l->fair);
+            pthread_mutex_unlock(&l->mutex);
+            break;
+        case RW_BIGREADER:
+            ret = br_rdlock_until(l, self, abstime);
+            break;
+        case RW_PHASEFAIR:
+            ret = pf_rdlock_until(&l->pf, abstime);
+            break;
+        case RW_BIASED:
+            ret = bias_rdlock(l, self, abstime);
+            break;
+        default:
+            ret = RW_FAIL;
+    }
+    return ret;
+}
+
+/*
+ * 정책대로 writer가 되어 cs에 들어가되 abstime까지만 기다린다. abstime이 NULL이면 기다리지 않는다.
+ */
+static int policy_wrlock_until(rwlock_t *l, const struct timespec *abstime)
+{
+    int ret = RW_SUCCESS;
+
+    switch (l->type) {
+        case RW_READER:
+        case RW_WRITER:
+            ret = cv_wrlock(l, abstime);
+            break;
+        case RW_FAIR:
+            if (mutex_lock_until(&l->fair, abstime) != 0)
+                return giveup(abstime);
+            if (sem_wait_until(&l->wrt, abstime) != 0)
+                ret = giveup(abstime);
+            pthread_mutex_unlock(&l->fair);
+            break;
+        case RW_BIGREADER:
+            ret = br_wrlock_until(l, abstime);
+            break;
+        case RW_PHASEFAIR:
+            ret = pf_wrlock_until(&l->pf, abstime);
+            break;
+        case RW_BIASED:
+            if ((ret = cv_wrlock(l, abstime)) == RW_SUCCESS)
+                ret = bias_revoke(l, abstime);
+            break;
+        default:
+            ret = RW_FAIL;
+    }
+    return ret;
+}
+
+/*
+ * 업그레이드나 다운그레이드가 진행 중이면 pending이 0보다 크다. 그 사이에 writer로 cs를 얻은 스레드는
+ * 아무것도 하지 않고 cs를 내준 다음, pending이 자기 몫인 mine 이하로 내려갈 때까지 p_cond에서 기다린다.
+ * mine은 upgrader가 1, 일반 writer가 0이다. 시간이 다 되었으면 ETIMEDOUT을 리턴한다.
+ * RW_FAIR의 reader는 mutex를 잡은 채로 wrt를 기다리므로, cs를 가진 스레드도 잡을 수 있도록 따로 pmutex를 쓴다.
+ */
+static int wait_settled(rwlock_t *l, int mine, const struct timespec *abstime)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&l->pmutex);
+    while (atomic_load(&l->pending) > mine)
+        if (cond_wait_until(&l->p_cond, &l->pmutex, abstime) == ETIMEDOUT) {
+            ret = atomic_load(&l->pending) > mine ? ETIMEDOUT : 0;
+            break;
+        }
+    pthread_mutex_unlock(&l->pmutex);
+    return ret;
+}
+
+/*
+ * 업그레이드나 다운그레이드를 마치고 pending을 내린 다음, 비켜서 기다리던 writer를 모두 깨운다.
+ */
+static void settle(rwlock_t *l)
+{
+    pthread_mutex_lock(&l->pmutex);
+    atomic_fetch_sub(&l->pending, 1);
+    pthread_cond_broadcast(&l->p_cond);
+    pthread_mutex_unlock(&l->pmutex);
+}
+
+/*
+ * 정책대로 writer가 되어 cs에 들어가되, 업그레이드나 다운그레이드가 진행 중이면 비켜 준다.
+ * 그 스레드는 reader에서 writer로, 또는 writer에서 reader로 옮겨가는 사이에 cs를 잠깐 비우는데,
+ * 그때 들어온 writer가 내용을 바꾸면 안 되기 때문이다. pending은 옮겨가기 전에 올리므로,
+ * 그 스레드가 비운 cs를 얻은 writer는 락을 통해 반드시 pending을 본다.
+ */
+static void wrlock_settled(rwlock_t *l, int mine)
+{
+    while (1) {
+        policy_wrlock(l);
+        if (atomic_load(&l->pending) <= mine)
+            return;
+        policy_wrunlock(l);
+        wait_settled(l, mine, &forever);
+    }
+}
+
+/*
+ * writer로 cs에 들어가되 abstime까지만 기다린다. 업그레이드나 다운그레이드가 끝나기를 기다리는 시간도
+ * 제한에 포함된다.
+ */
+static int wrlock_until(rwlock_t *l, const struct timespec *abstime)
+{
+    int ret;
+
+    while (1) {
+        if ((ret = policy_wrlock_until(l, abstime)) != RW_SUCCESS)
+            return ret;
+        if (atomic_load(&l->pending) == 0)
+            return RW_SUCCESS;
+        policy_wrunlock(l);
+        if (wait_settled(l, 0, abstime) == ETIMEDOUT)
+            return giveup(abstime);
+    }
+}
+
+/*
+ * 기다리지 않고 reader로 들어간다. 들어가면 RW_SUCCESS를, 바로 들어갈 수 없으면 RW_BUSY를 리턴한다.
+ */
+int rw_try_rdlock(rwlock_t *l, rw_thread_t *self)
+{
+    return rdlock_until(l, self, NULL);
+}
+
+/*
+ * 기다리지 않고 writer로 들어간다. 들어가면 RW_SUCCESS를, 바로 들어갈 수 없으면 RW_BUSY를 리턴한다.
+ */
+int rw_try_wrlock(rwlock_t *l, rw_thread_t *self)
+{
+    (void)self;
+    return wrlock_until(l, NULL);
+}
+
+/*
+ * abstime까지만 기다려서 reader로 들어간다. 들어가면 RW_SUCCESS를, 시간이 다 되면 RW_TIMEDOUT을 리턴한다.
+ */
+int rw_timed_rdlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    return rdlock_until(l, self, abstime);
+}
+
+/*
+ * abstime까지만 기다려서 writer로 들어간다. 들어가면 RW_SUCCESS를, 시간이 다 되면 RW_TIMEDOUT을 리턴한다.
+ */
+int rw_timed_wrlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime)
+{
+    (void)self;
+    return wrlock_until(l, abstime);
+}
+
+/*
+ * writer로 cs에 들어간다. writer는 umutex를 잡지 않으므로 정책이 정한 순서대로 기다린다.
+ */
+void rw_wrlock(rwlock_t *l, rw_thread_t *self)
+{
+    (void)self;
+    wrlock_settled(l, 0);
+}
+
+/*
+ * writer로 들어간 cs에서 나온다. 업그레이드해서 writer가 된 경우에도 이것으로 나온다.
+ */
+void rw_wrunlock(rwlock_t *l, rw_thread_t *self)
+{
+    (void)self;
+    policy_wrunlock(l);
+}
+
+/*
+ * 업그레이드할 수 있는 reader로 cs에 들어간다. upgrader끼리는 umutex로 배제하므로 한 번에 한 스레드만
+ * upgrader가 될 수 있지만, 일반 reader와는 함께 cs에 있을 수 있다.
+ */
+void rw_uplock(rwlock_t *l, rw_thread_t *self)
+{
+    pthread_mutex_lock(&l->umutex);
+    rw_rdlock(l, self);
+}
+
+/*
+ * 업그레이드하지 않은 upgrader로 들어간 cs에서 나온다.
+ */
+void rw_upunlock(rwlock_t *l, rw_thread_t *self)
+{
+    rw_rdunlock(l, self);
+    pthread_mutex_unlock(&l->umutex);
+}
+
+/*
+ * upgrader를 writer로 올린다. pending을 올린 다음 reader에서 나와 정책대로 writer가 되므로, 일반 reader가
+ * 모두 나가기를 기다리는 사이에 다른 writer가 cs를 얻더라도 비켜 주어서 upgrader가 읽은 내용을 바꾸지 못한다.
+ * 다운그레이드가 진행 중이면 upgrader도 비켜 준다. writer가 되면 umutex를 놓으며, 나올 때는 rw_wrunlock()을 부른다.
+ */
+void rw_upgrade(rwlock_t *l, rw_thread_t *self)
+{
+    atomic_fetch_add(&l->pending, 1);
+    rw_rdunlock(l, self);
+    wrlock_settled(l, 1);
+    settle(l);
+    pthread_mutex_unlock(&l->umutex);
+}
+
+/*
+ * writer를 일반 reader로 내린다. pending을 올린 다음 writer에서 나와 reader로 들어가므로, 그 사이에 cs를 얻은
+ * writer는 비켜 주고 방금 쓴 내용을 그대로 읽을 수 있다. 나올 때는 rw_rdunlock()을 부른다.
+ */
+void rw_downgrade(rwlock_t *l, rw_thread_t *self)
+{
+    atomic_fetch_add(&l->pending, 1);
+    policy_wrunlock(l);
+    rw_rdlock(l, self);
+    settle(l);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef RWLOCK_H
+#define RWLOCK_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "pflock.h"
+
+#define RW_READER 0
+#define RW_WRITER 1
+#define RW_FAIR 2
+#define RW_BIGREADER 3
+#define RW_PHASEFAIR 4
+#define RW_BIASED 5
+#define RW_NSLOT 64
+#define RW_CACHELINE 64
+#define RW_SUCCESS 0
+#define RW_FAIL 4
+#define RW_BUSY 5
+#define RW_TIMEDOUT 6
+#define RW_BIAS_NONE 0
+#define RW_BIAS_ON 1
+#define RW_BIAS_OFF 2
+#define RW_REBIAS 64
+
+/*
+ * Big-reader 락에서 reader가 자기 수를 세는 카운터
+ *
+ * 카운터마다 캐시라인 하나를 혼자 차지하므로 서로 다른 슬롯의 reader는 캐시라인을 공유하지 않는다.
+ */
+typedef struct {
+    _Alignas(RW_CACHELINE) atomic_int readers;      /* 이 슬롯에서 cs에 들어간 reader의 수 */
+} rw_slot_t;
+
+/*
+ * 여러 정책의 reader-writer 락이 공유하는 구조체 타입
+ *
+ * type은 RW_READER, RW_WRITER, RW_FAIR, RW_BIGREADER, RW_PHASEFAIR, RW_BIASED 중 하나이다.
+ *   RW_READER는 reader_prefer.c처럼 cs에 reader가 있으면 늦게 온 reader도 들어간다. writer가 굶주릴 수 있다.
+ *   RW_WRITER는 writer_prefer.c처럼 기다리는 writer가 있으면 새 reader가 들어가지 못한다.
+ *   RW_FAIR는 reader와 writer가 모두 fair 뮤텍스락을 먼저 잡고 들어가므로 fair를 얻은 순서대로 들어간다.
+ *   writer와 reader 무리는 wrt 세마포로 상호배타한다. wrt는 첫 reader가 잡고 마지막 reader가 풀어서
+ *   잡은 스레드와 푸는 스레드가 다를 수 있으므로 뮤텍스 대신 세마포를 쓴다. fair를 얻는 순서는 뮤텍스락의
+ *   스케줄링에 달려 있으므로 도착 순서를 엄밀하게 보장하지는 않는다.
+ *   RW_BIGREADER는 reader가 공유 뮤텍스를 잡지 않는다. reader는 자기 슬롯의 카운터만 올리고
+ *   writer 플래그를 확인하며, writer는 플래그를 세운 다음 모든 슬롯의 카운터가 0이 되기를 기다린다.
+ *   reader는 서로 다른 캐시라인만 건드리므로 읽기가 대부분인 환경에서 reader 수에 비례해서 확장된다.
+ *   대신 writer는 모든 슬롯을 읽어야 하므로 쓰기가 비싸다.
+ *   RW_PHASEFAIR는 Brandenburg-Anderson의 티켓 기반 phase-fair 락이다. reader 단계와 writer 단계가
+ *   번갈아 오므로, reader는 많아야 writer 한 명을 기다리고 writer는 앞선 writer와 그 사이의 reader
+ *   단계만 기다린다. reader는 원자적 덧셈 한 번으로 들어가고 한 번으로 나온다.
+ *   RW_BIASED는 읽기를 거의 혼자 하는 스레드(owner)에게 치우친 락이다. owner는 자기 슬롯의 카운터에
+ *   1을 저장하고 bias를 다시 읽는 것만으로 들어가므로 원자적 읽기-수정-쓰기도 뮤텍스락도 쓰지 않는다.
+ *   나머지 스레드는 RW_READER와 같은 방법으로 들어간다. writer는 RW_READER처럼 cs를 얻은 다음, bias를
+ *   RW_BIAS_OFF로 바꾸고 membarrier()로 모든 스레드에 메모리 울타리를 치게 하는 핸드셰이크를 거쳐
+ *   owner가 cs에서 나오기를 기다린다. owner는 울타리를 치지 않는 대신 이 핸드셰이크가 owner의 저장과
+ *   writer의 읽기 순서를 보장한다. try 락이나 시간 제한이 있는 writer는 owner가 나오기를 제한 시간까지만
+ *   기다리고, 그래도 나오지 않으면 bias를 RW_BIAS_OFF로 둔 채 포기한다. 다음 writer는 그 owner가 나오기를
+ *   이어서 기다린다. writer 없이 한 스레드가 느린 길로 RW_REBIAS 번 연달아 읽으면 그 스레드가 다시
+ *   owner가 된다. 다른 스레드가 느린 길로 읽으면 처음부터 다시 센다.
+ *   membarrier()를 쓸 수 없는 시스템이나 스레드가 RW_NSLOT 개보다 많아 슬롯을 같이 쓰는 경우에는
+ *   owner를 정하지 않으므로 RW_READER와 같다.
+ * mutex, r_cond, w_cond와 r_wait, r_act, w_wait, w_act는 RW_READER와 RW_WRITER가 사용하는
+ * 뮤텍스락, 조건변수와 공유 변수로 원래 프로그램에서와 같은 의미이다. 다만 락을 넘겨줄 때는 나가는 스레드가
+ * 기다리던 reader 무리의 r_wait을 r_act로 옮기고 r_gen을 올리거나, 기다리던 writer에게 w_act를 1로 둔 채
+ * w_handoff를 올려서 깨우므로, 깨어난 스레드는 조건을 다시 따지지 않고 바로 cs에 들어간다.
+ * slots는 RW_NSLOT 개의 reader 카운터이고, writer는 cs에 writer가 있거나 들어가려고 하면 1이다.
+ * RW_BIASED에서는 owner가 빠른 길로 cs에 있는 동안 자기 슬롯의 카운터가 1이다.
+ * wmutex는 writer가 cs를 떠날 때까지 잡고 있으므로, 플래그를 보고 물러난 reader는 여기서 잠든다.
+ * nthread는 슬롯을 나눠주기 위해 지금까지 등록된 스레드의 수를 센다.
+ * umutex는 업그레이드할 수 있는 reader(upgrader)끼리만 잡는 뮤텍스락이다. upgrader는 이것을 잡고 정책대로
+ * reader가 되므로 일반 reader와는 함께 cs에 있지만 다른 upgrader와는 함께 있지 않다. writer는 umutex를 잡지
+ * 않으므로 정책의 순서대로 기다린다. 업그레이드는 reader에서 나와 writer로 다시 들어가고, 다운그레이드는
+ * writer에서 나와 reader로 들어가는데, 그 사이에 cs가 잠깐 비므로 옮겨가는 동안 pending을 올려둔다.
+ * 그때 cs를 얻은 writer는 아무것도 하지 않고 cs를 내준 다음 pending이 내려갈 때까지 p_cond에서 기다리므로,
+ * 옮겨가는 스레드가 읽었거나 쓴 내용을 다른 writer가 바꿀 수 없다.
+ * bias, owner, last와 quiet는 RW_BIASED가 사용한다. owner는 치우침을 받은 스레드의 슬롯 번호이다.
+ * quiet는 last 슬롯의 reader가 느린 길로 연달아 들어간 횟수로, mutex를 잡고 세며 writer가 0으로 되돌린다.
+ * pf는 RW_PHASEFAIR가 사용하는 pflock.h의 티켓 락이다.
+ */
+typedef struct {
+    int type;                   /* 락의 정책 */
+    pthread_mutex_t mutex;      /* 공유 변수를 조회하기 위한 뮤텍스락 */
+    pthread_cond_t r_cond;      /* reader의 조건변수 */
+    pthread_cond_t w_cond;      /* writer의 조건변수 */
+    int r_wait;                 /* cs 진입을 기다리는 reader의 수 */
+    int r_act;                  /* cs에 진입한 reader의 수 */
+    int w_wait;                 /* cs 진입을 기다리는 writer의 수 */
+    int w_act;                  /* cs에 진입한 writer의 수 (0 또는 1) */
+    unsigned long r_gen;        /* 기다리던 reader 무리를 들여보낸 횟수 */
+    int w_handoff;              /* writer에게 넘겨주었지만 아직 가져가지 않은 cs의 수 (0 또는 1) */
+    pthread_mutex_t fair;       /* RW_FAIR: reader와 writer의 진입 순서를 정하는 락 */
+    sem_t wrt;                  /* RW_FAIR: writer와 reader 무리를 상호배타하는 세마포 */
+    int readcnt;                /* RW_FAIR: cs에 진입한 reader의 수 */
+    rw_slot_t *slots;           /* RW_BIGREADER, RW_BIASED: reader 카운터 배열 */
+    _Alignas(RW_CACHELINE) atomic_int writer;   /* RW_BIGREADER: writer가 있으면 1 */
+    pthread_mutex_t wmutex;     /* RW_BIGREADER: writer 사이의 상호배타, 물러난 reader가 기다리는 곳 */
+    atomic_int nthread;         /* RW_BIGREADER, RW_BIASED: 등록된 스레드의 수 */
+    pflock_t pf;                /* RW_PHASEFAIR: 티켓 기반 phase-fair 락 */
+    pthread_mutex_t umutex;     /* upgrader 사이의 상호배타 */
+    atomic_int pending;         /* 진행 중인 업그레이드와 다운그레이드의 수 */
+    pthread_mutex_t pmutex;     /* p_cond의 뮤텍스락 */
+    pthread_cond_t p_cond;      /* pending이 내려가기를 기다리는 writer의 조건변수 */
+    _Alignas(RW_CACHELINE) atomic_int bias;     /* RW_BIASED: owner가 빠른 길로 들어갈 수 있는지 */
+    atomic_int owner;           /* RW_BIASED: 치우침을 받은 스레드의 슬롯, 없으면 -1 */
+    int last;                   /* RW_BIASED: 마지막으로 느린 길로 들어간 reader의 슬롯 */
+    int quiet;                  /* RW_BIASED: last의 reader가 느린 길로 연달아 들어간 횟수 */
+} rwlock_t;
+
+/*
+ * 락을 사용하는 스레드마다 하나씩 가지는 정보
+ *
+ * slot은 RW_BIGREADER와 RW_BIASED에서 이 스레드가 reader로 들어갈 때 올리는 카운터의 번호이다.
+ * 스레드가 RW_NSLOT 개보다 많으면 여러 스레드가 한 슬롯을 같이 쓰지만 정확성에는 문제가 없다.
+ * biased는 RW_BIASED에서 이 스레드가 owner로서 빠른 길로 들어갔으면 1이다.
+ */
+typedef struct {
+    int slot;                   /* reader 카운터의 번호 */
+    int biased;                 /* 빠른 길로 cs에 들어갔는지 */
+} rw_thread_t;
+
+int rwlock_init(rwlock_t *l, int type);
+void rwlock_destroy(rwlock_t *l);
+void rw_thread_init(rwlock_t *l, rw_thread_t *self);
+void rw_rdlock(rwlock_t *l, rw_thread_t *self);
+void rw_rdunlock(rwlock_t *l, rw_thread_t *self);
+void rw_wrlock(rwlock_t *l, rw_thread_t *self);
+void rw_wrunlock(rwlock_t *l, rw_thread_t *self);
+int rw_try_rdlock(rwlock_t *l, rw_thread_t *self);
+int rw_try_wrlock(rwlock_t *l, rw_thread_t *self);
+int rw_timed_rdlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime);
+int rw_timed_wrlock(rwlock_t *l, rw_thread_t *self, const struct timespec *abstime);
+void rw_uplock(rwlock_t *l, rw_thread_t *self);
+void rw_upunlock(rwlock_t *l, rw_thread_t *self);
+void rw_upgrade(rwlock_t *l, rw_thread_t *self);
+void rw_downgrade(rwlock_t *l, rw_thread_t *self);
+
+#endif
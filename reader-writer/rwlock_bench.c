@@ -0,0 +1,496 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "rwlock.h"
+#include "seqlock.h"
+#include "rcu.h"
+
+#define NREAD 20
+#define NWRITE 5
+#define DURATION 1000
+#define SLEEPTIME 100000
+#define ROWS 50
+#define COLS 64
+#define RW_SEQLOCK 6
+#define RW_RCU 7
+#define NPOLICY 8
+#define CACHELINE 64
+#define NSUB 16
+#define NBUCKET 1024
+
+/*
+ * 스레드마다 하나씩 가지는 측정 정보
+ *
+ * 다른 스레드의 기록과 캐시라인을 공유하지 않도록 캐시라인 경계에 맞춘다.
+ * hist는 락을 얻기까지 걸린 시간(나노초)의 히스토그램이다. 값이 NSUB보다 작으면 그대로 칸 번호가 되고,
+ * 크면 2의 거듭제곱 구간마다 NSUB 칸으로 나누므로 상대 오차가 1/NSUB 이내이다.
+ * starve는 한 번 기다리기 시작해서 cs에 들어가거나 측정이 끝날 때까지 걸린 시간 중 가장 긴 것으로,
+ * 끝내 들어가지 못한 스레드의 기다림도 포함한다. 시간 제한 때문에 포기했으면 마지막으로 락을 얻은 때부터,
+ * 한 번도 얻지 못했으면 스레드가 시작한 때부터 포기할 때까지를 기다린 시간으로 본다.
+ */
+typedef struct {
+    _Alignas(CACHELINE) int id;     /* 스레드 번호 */
+    long ops;                       /* 측정이 끝나기 전에 cs에 들어간 횟수 */
+    long torn;                      /* 일관되지 않은 복사본이나 남이 고친 이미지를 본 횟수 */
+    long retries;                   /* reader: seqlock에서 다시 읽은 횟수 */
+    long shed;                      /* 시간 제한 안에 락을 얻지 못해 포기한 횟수 */
+    long starve;                    /* 가장 오래 기다린 시간 */
+    long last;                      /* 마지막으로 락을 얻은 시각, 처음에는 스레드가 시작한 시각 */
+    long hist[NBUCKET];             /* 락을 얻기까지 걸린 시간의 히스토그램 */
+} worker_t;
+
+/*
+ * RCU에서 writer가 새로 만들어 발행하는 이미지 한 벌
+ */
+typedef struct {
+    char cell[ROWS][COLS];
+} version_t;
+
+/*
+ * 정책의 이름으로, rwlock.h의 정책 번호와 RW_SEQLOCK, RW_RCU를 칸 번호로 쓴다.
+ */
+static const char *const name[NPOLICY] = {"reader", "writer", "fair", "bigreader", "phasefair", "biased", "seqlock", "rcu"};
+
+/*
+ * 모든 스레드가 공유하는 실험 환경
+ *
+ * image는 writer가 cs에서 통째로 다시 쓰는 공유 데이터로, 원래 프로그램의 얼굴 이미지에 해당한다.
+ * writer는 모든 칸을 같은 문자로 채우므로, reader가 복사한 이미지에 다른 문자가 섞여 있으면
+ * writer와 겹쳐서 읽은 것이다.
+ * RCU에서는 image 대신 current가 가리키는 버전을 읽고, writer는 새 버전을 만들어 current를 바꾼다.
+ * rcu_wlock은 RCU writer 사이의 상호배타를 위한 뮤텍스락이다.
+ */
+char image[ROWS][COLS];
+int policy;
+rwlock_t lock;
+seqlock_t seq;
+rcu_domain_t rcu;
+version_t *_Atomic current;
+pthread_mutex_t rcu_wlock;
+atomic_bool alive = true;
+_Atomic long stop;
+int sleeptime = SLEEPTIME;
+int cslength = 0;
+bool upgradable = false;
+long timeout = 0;
+
+static inline long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/*
+ * 나노초 값 v가 들어갈 히스토그램 칸 번호를 구한다.
+ */
+static int bucket(long v)
+{
+    int e;
+
+    if (v < NSUB)
+        return v < 0 ? 0 : (int)v;
+    e = 63 - __builtin_clzl((unsigned long)v);
+    return (e - 3) * NSUB + (int)((v >> (e - 4)) & (NSUB - 1));
+}
+
+/*
+ * 히스토그램 칸 i에 들어가는 가장 큰 값을 구한다.
+ */
+static long bucket_max(int i)
+{
+    int e = i / NSUB + 3;
+
+    if (i < NSUB)
+        return i;
+    return ((long)(NSUB + i % NSUB + 1) << (e - 4)) - 1;
+}
+
+/*
+ * start에 기다리기 시작해서 방금 락을 얻은 것을 기록한다. 측정이 끝난 뒤에 얻은 것은 ops와 히스토그램에 넣지 않고,
+ * 측정이 끝날 때까지 기다린 시간만 starve에 반영한다.
+ */
+static void record(worker_t *w, long start)
+{
+    long t = now_ns(), end;
+
+    if (alive) {
+        w->hist[bucket(t - start)]++;
+        w->ops++;
+        w->last = end = t;
+    }
+    else {
+        end = atomic_load(&stop);
+        if (end < start)
+            end = start;
+    }
+    if (end - start > w->starve)
+        w->starve = end - start;
+}
+
+/*
+ * 시간 제한 안에 락을 얻지 못하고 포기한 것을 기록한다. 포기를 거듭해도 한 번의 기다림이 이어지는 것이므로,
+ * 마지막으로 락을 얻은 때부터 지금까지, 측정이 끝났으면 끝날 때까지를 starve에 반영한다.
+ */
+static void shed(worker_t *w)
+{
+    long end = alive ? now_ns() : atomic_load(&stop);
+
+    w->shed++;
+    if (end - w->last > w->starve)
+        w->starve = end - w->last;
+}
+
+/*
+ * 지금부터 timeout 나노초 뒤의 시각을 CLOCK_REALTIME 기준으로 구한다.
+ */
+static struct timespec *deadline(struct timespec *abstime)
+{
+    clock_gettime(CLOCK_REALTIME, abstime);
+    abstime->tv_sec += (abstime->tv_nsec + timeout) / 1000000000L;
+    abstime->tv_nsec = (abstime->tv_nsec + timeout) % 1000000000L;
+    return abstime;
+}
+
+/*
+ * cs 안에서 cslength 나노초 동안 일한다.
+ */
+static void hold(void)
+{
+    long t;
+
+    if (cslength > 0)
+        for (t = now_ns(); now_ns() - t < cslength; )
+            ;
+}
+
+/*
+ * 복사한 이미지의 모든 칸이 같은 문자인지 검사한다.
+ */
+static bool consistent(char copy[ROWS][COLS])
+{
+    for (int r = 0; r < ROWS; ++r)
+        for (int c = 0; c < COLS; ++c)
+            if (copy[r][c] != copy[0][0])
+                return false;
+    return true;
+}
+
+/*
+ * Reader 스레드는 공유 이미지의 복사본을 얻어서 일관된지 검사하는 일을 반복한다.
+ * seqlock은 락 없이 복사하고, 복사하는 사이에 writer가 다녀갔으면 다시 복사한다.
+ * RCU는 현재 버전을 가리키는 포인터를 따라가서 복사하며, writer를 기다리지도 다시 읽지도 않는다.
+ * 락을 얻기까지 걸린 시간은 seqlock에서 처음 읽기를 시작할 때까지이며, 다시 읽은 횟수는 따로 센다.
+ * 아무것도 출력하지 않고, cs에서는 이미지를 복사한 다음 cslength 나노초 동안 일한다.
+ */
+void *reader(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    rw_thread_t self;
+    rcu_thread_t rself;
+    char copy[ROWS][COLS];
+    version_t *v;
+    struct timespec abstime;
+    unsigned s;
+    long start;
+
+    rw_thread_init(&lock, &self);
+    rcu_thread_init(&rcu, &rself);
+    w->last = now_ns();
+    while (alive) {
+        start = now_ns();
+        if (policy == RW_RCU) {
+            rcu_read_lock(&rcu, &rself);
+            record(w, start);
+            v = (version_t *)rcu_dereference((void *_Atomic *)&current);
+            memcpy(copy, v->cell, sizeof(copy));
+            hold();
+            rcu_read_unlock(&rself);
+        }
+        else if (policy == RW_SEQLOCK) {
+            s = seq_read_begin(&seq);
+            record(w, start);
+            while (true) {
+                memcpy(copy, image, sizeof(copy));
+                hold();
+                if (!seq_read_retry(&seq, s))
+                    break;
+                w->retries++;
+                s = seq_read_begin(&seq);
+            }
+        }
+        else {
+            if (timeout == 0)
+                rw_rdlock(&lock, &self);
+            else if (rw_timed_rdlock(&lock, &self, deadline(&abstime)) != RW_SUCCESS) {
+                shed(w);
+                continue;
+            }
+            record(w, start);
+            memcpy(copy, image, sizeof(copy));
+            hold();
+            rw_rdunlock(&lock, &self);
+        }
+        if (!consistent(copy))
+            w->torn++;
+    }
+    rcu_thread_destroy(&rcu, &rself);
+    pthread_exit(NULL);
+}
+
+/*
+ * Writer 스레드는 공유 이미지를 자기 문자로 다시 쓰고, sleeptime 나노초 안에서 랜덤하게 쉰다.
+ * RCU는 이미지를 제자리에서 고치지 않고 새 버전을 채워서 발행한 다음, 옛 버전을 유예 기간 뒤에 반납한다.
+ * upgradable이면 upgrader로 들어가서 cs의 일을 reader들과 함께 하고, 이미지가 이미 자기 문자이면 그냥 나온다.
+ * 아니면 writer로 올라가서 이미지를 고치는 동안만 reader를 막고, 다시 reader로 내려와서 자기가 쓴 것을 확인한다.
+ */
+void *writer(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    rw_thread_t self;
+    unsigned seed = (unsigned)time(NULL) ^ (unsigned)w->id;
+    struct timespec req, abstime;
+    version_t *v;
+    long start;
+
+    rw_thread_init(&lock, &self);
+    w->last = now_ns();
+    while (alive) {
+        if (policy == RW_RCU) {
+            if ((v = (version_t *)malloc(sizeof(version_t))) == NULL) {
+                fprintf(stderr, "malloc error\n");
+                exit(-1);
+            }
+            memset(v->cell, 'a' + w->id % 26, sizeof(v->cell));
+            start = now_ns();
+            pthread_mutex_lock(&rcu_wlock);
+            record(w, start);
+            hold();
+            v = (version_t *)rcu_publish((void *_Atomic *)&current, v);
+            pthread_mutex_unlock(&rcu_wlock);
+            if (rcu_retire(&rcu, v, free) != RCU_SUCCESS) {
+                fprintf(stderr, "rcu_retire error\n");
+                exit(-1);
+            }
+        }
+        else if (policy == RW_SEQLOCK) {
+            start = now_ns();
+            seq_write_lock(&seq);
+            record(w, start);
+            memset(image, 'a' + w->id % 26, sizeof(image));
+            hold();
+            seq_write_unlock(&seq);
+        }
+        else if (upgradable) {
+            start = now_ns();
+            rw_uplock(&lock, &self);
+            record(w, start);
+            hold();
+            if (image[0][0] == 'a' + w->id % 26)
+                rw_upunlock(&lock, &self);
+            else {
+                rw_upgrade(&lock, &self);
+                memset(image, 'a' + w->id % 26, sizeof(image));
+                rw_downgrade(&lock, &self);
+                if (image[ROWS-1][COLS-1] != 'a' + w->id % 26)
+                    w->torn++;
+                rw_rdunlock(&lock, &self);
+            }
+        }
+        else {
+            start = now_ns();
+            if (timeout == 0)
+                rw_wrlock(&lock, &self);
+            else if (rw_timed_wrlock(&lock, &self, deadline(&abstime)) != RW_SUCCESS) {
+                shed(w);
+                continue;
+            }
+            record(w, start);
+            memset(image, 'a' + w->id % 26, sizeof(image));
+            hold();
+            rw_wrunlock(&lock, &self);
+        }
+        if (sleeptime > 0) {
+            req.tv_sec = 0;
+            req.tv_nsec = rand_r(&seed) % sleeptime;
+            nanosleep(&req, NULL);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+/*
+ * 스레드 w[from]부터 w[to-1]까지의 히스토그램을 합쳐서 락을 얻기까지 걸린 시간의 p50, p99, p99.9와
+ * 최댓값, 그리고 가장 긴 기다림을 CSV 항목으로 출력한다. 락을 한 번도 얻지 못했으면 시간은 0이다.
+ */
+static void print_latency(worker_t *w, int from, int to)
+{
+    static const double pct[3] = {0.50, 0.99, 0.999};
+    long hist[NBUCKET] = {0}, n = 0, sum, starve = 0, max = 0;
+    int i, b, k;
+
+    for (i = from; i < to; ++i) {
+        for (b = 0; b < NBUCKET; ++b)
+            hist[b] += w[i].hist[b];
+        if (w[i].starve > starve)
+            starve = w[i].starve;
+    }
+    for (b = 0; b < NBUCKET; ++b)
+        if (hist[b] > 0) {
+            n += hist[b];
+            max = bucket_max(b);
+        }
+    for (k = 0; k < 3; ++k) {
+        for (b = 0, sum = 0; b < NBUCKET && n > 0; ++b)
+            if ((sum += hist[b]) >= pct[k] * n)
+                break;
+        printf(",%ld", n > 0 ? bucket_max(b) : 0);
+    }
+    printf(",%ld,%ld", max, starve);
+}
+
+/*
+ * 한 정책을 측정하고 결과를 CSV 한 줄로 출력한다.
+ */
+static void run(int p, int nr, int nw, int duration)
+{
+    pthread_t *tid = (pthread_t *)malloc(sizeof(pthread_t)*(nr + nw));
+    worker_t *w = (worker_t *)aligned_alloc(CACHELINE, sizeof(worker_t)*(nr + nw));
+    long reads = 0, writes = 0, torn = 0, retries = 0, shed = 0;
+    long start;
+    double sec;
+    int i;
+
+    if (tid == NULL || w == NULL) {
+        fprintf(stderr, "malloc error\n");
+        exit(-1);
+    }
+    policy = p;
+    rwlock_init(&lock, p >= RW_SEQLOCK ? RW_READER : p);
+    seqlock_init(&seq);
+    rcu_init(&rcu);
+    pthread_mutex_init(&rcu_wlock, NULL);
+    memset(image, 'a', sizeof(image));
+    if ((current = (version_t *)malloc(sizeof(version_t))) == NULL) {
+        fprintf(stderr, "malloc error\n");
+        exit(-1);
+    }
+    memset(current->cell, 'a', sizeof(current->cell));
+    memset(w, 0, sizeof(worker_t)*(nr + nw));
+    alive = true;
+    start = now_ns();
+    for (i = 0; i < nr + nw; ++i) {
+        w[i].id = i;
+        if (pthread_create(tid+i, NULL, i < nr ? reader : writer, w+i) != 0) {
+            fprintf(stderr, "pthread_create error\n");
+            exit(-1);
+        }
+    }
+    usleep(duration * 1000);
+    atomic_store(&stop, now_ns());
+    alive = false;
+    for (i = 0; i < nr + nw; ++i)
+        pthread_join(tid[i], NULL);
+    sec = (stop - start) / 1e9;
+    for (i = 0; i < nr; ++i) {
+        reads += w[i].ops;
+        torn += w[i].torn;
+        retries += w[i].retries;
+    }
+    for (i = nr; i < nr + nw; ++i)
+        writes += w[i].ops;
+    printf("%s,%d,%d,%d,%d,%.0f,%.0f", name[p], nr, nw, cslength, sleeptime, reads / sec, writes / sec);
+    print_latency(w, 0, nr);
+    print_latency(w, nr, nr + nw);
+    for (i = 0; i < nr + nw; ++i)
+        shed += w[i].shed;
+    for (i = nr; i < nr + nw; ++i)
+        torn += w[i].torn;
+    printf(",%ld,%ld,%ld\n", torn, retries, shed);
+    fflush(stdout);
+    rcu_destroy(&rcu);
+    free(current);
+    pthread_mutex_destroy(&rcu_wlock);
+    seqlock_destroy(&seq);
+    rwlock_destroy(&lock);
+    free(w);
+    free(tid);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-p reader|writer|fair|bigreader|phasefair|biased|seqlock|rcu|all] [-r readers]"
+                    " [-w writers] [-c cs-ns] [-s sleep-ns] [-t timeout-ns] [-d milliseconds] [-u]\n", prog);
+    exit(-1);
+}
+
+/*
+ * 메인 함수는 인자로 받은 설정대로 reader-writer 정책을 하나씩 또는 모두 측정한다.
+ * reader와 writer의 수로 읽기와 쓰기의 비율과 스레드 수를, -c로 cs의 길이를, -s로 writer가 쉬는 시간을 정한다.
+ * -t를 주면 락 기반 정책의 스레드는 timeout 나노초까지만 기다리고, 그 안에 락을 얻지 못하면 포기한다.
+ * -u를 주면 락 기반 정책의 writer는 업그레이드할 수 있는 reader로 들어가서 필요할 때만 writer로 올라간다.
+ * 결과는 정책마다 CSV 한 줄이며, 시간의 단위는 나노초이다.
+ */
+int main(int argc, char *argv[])
+{
+    int opt, p = -1, nr = NREAD, nw = NWRITE, duration = DURATION;
+
+    while ((opt = getopt(argc, argv, "p:r:w:c:s:t:d:u")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "all") == 0) {
+                    p = -1;
+                    break;
+                }
+                for (p = 0; p < NPOLICY && strcmp(optarg, name[p]) != 0; ++p)
+                    ;
+                if (p == NPOLICY)
+                    usage(argv[0]);
+                break;
+            case 'r':
+                nr = atoi(optarg);
+                break;
+            case 'w':
+                nw = atoi(optarg);
+                break;
+            case 'u':
+                upgradable = true;
+                break;
+            case 't':
+                timeout = atol(optarg);
+                break;
+            case 'c':
+                cslength = atoi(optarg);
+                break;
+            case 's':
+                sleeptime = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (nr < 0 || nw < 0 || nr + nw == 0 || sleeptime < 0 || sleeptime >= 1000000000 || cslength < 0 || timeout < 0 || duration <= 0)
+        usage(argv[0]);
+    printf("policy,readers,writers,cs_ns,sleep_ns,reads_per_s,writes_per_s,"
+           "read_p50_ns,read_p99_ns,read_p999_ns,read_max_ns,read_starve_ns,"
+           "write_p50_ns,write_p99_ns,write_p999_ns,write_max_ns,write_starve_ns,torn,retries,shed\n");
+    if (p >= 0)
+        run(p, nr, nw, duration);
+    else
+        for (p = 0; p < NPOLICY; ++p)
+            run(p, nr, nw, duration);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdlib.h>
+#include "rwstripe.h"
+
+/*
+ * 락 관리자를 nstripe 개의 구역으로 초기화한다. nstripe는 2의 거듭제곱으로 올리며 RWS_MAXSTRIPE를 넘을 수 없다.
+ * 구역 락은 모두 type 정책을 따른다. 성공하면 RWS_SUCCESS를, 실패하면 RWS_FAIL을 리턴한다.
+ */
+int rws_init(rwstripe_t *s, size_t nstripe, int type)
+{
+    size_t i;
+
+    if (nstripe == 0 || nstripe > RWS_MAXSTRIPE)
+        return RWS_FAIL;
+    s->nstripe = 1;
+    s->shift = 64;
+    while (s->nstripe < nstripe) {
+        s->nstripe <<= 1;
+        s->shift--;
+    }
+    s->type = type;
+    s->stripes = (rwlock_t *)aligned_alloc(RW_CACHELINE, sizeof(rwlock_t)*s->nstripe);
+    if (s->stripes == NULL)
+        return RWS_FAIL;
+    for (i = 0; i < s->nstripe; ++i)
+        if (rwlock_init(&s->stripes[i], type) != RW_SUCCESS) {
+            while (i > 0)
+                rwlock_destroy(&s->stripes[--i]);
+            free(s->stripes);
+            s->stripes = NULL;
+            return RWS_FAIL;
+        }
+    return RWS_SUCCESS;
+}
+
+/*
+ * 락 관리자가 사용하던 자원을 반납한다. 락을 기다리거나 가진 스레드가 없어야 한다.
+ */
+void rws_destroy(rwstripe_t *s)
+{
+    for (size_t i = 0; i < s->nstripe; ++i)
+        rwlock_destroy(&s->stripes[i]);
+    free(s->stripes);
+    s->stripes = NULL;
+}
+
+/*
+ * 스레드가 락 관리자를 사용하기 전에 구역마다 자신의 정보를 준비한다.
+ * 성공하면 RWS_SUCCESS를, 메모리가 없으면 RWS_FAIL을 리턴한다.
+ */
+int rws_thread_init(rwstripe_t *s, rws_thread_t *t)
+{
+    t->self = (rw_thread_t *)malloc(sizeof(rw_thread_t)*s->nstripe);
+    if (t->self == NULL)
+        return RWS_FAIL;
+    for (size_t i = 0; i < s->nstripe; ++i)
+        rw_thread_init(&s->stripes[i], &t->self[i]);
+    return RWS_SUCCESS;
+}
+
+/*
+ * 스레드의 정보를 반납한다. 잡고 있는 구역이 없어야 한다.
+ */
+void rws_thread_destroy(rws_thread_t *t)
+{
+    free(t->self);
+    t->self = NULL;
+}
+
+/*
+ * key가 속한 구역에 reader로 들어가고 나온다.
+ */
+void rws_rdlock(rwstripe_t *s, rws_thread_t *t, uint64_t key)
+{
+    size_t i = rws_stripe(s, key);
+
+    rw_rdlock(&s->stripes[i], &t->self[i]);
+}
+
+void rws_rdunlock(rwstripe_t *s, rws_thread_t *t, uint64_t key)
+{
+    size_t i = rws_stripe(s, key);
+
+    rw_rdunlock(&s->stripes[i], &t->self[i]);
+}
+
+/*
+ * key가 속한 구역에 writer로 들어가고 나온다.
+ */
+void rws_wrlock(rwstripe_t *s, rws_thread_t *t, uint64_t key)
+{
+    size_t i = rws_stripe(s, key);
+
+    rw_wrlock(&s->stripes[i], &t->self[i]);
+}
+
+void rws_wrunlock(rwstripe_t *s, rws_thread_t *t, uint64_t key)
+{
+    size_t i = rws_stripe(s, key);
+
+    rw_wrunlock(&s->stripes[i], &t->self[i]);
+}
+
+/*
+ * keys의 n개 키가 속한 구역 번호를 set에 오름차순으로, 중복 없이 모으고 그 수를 리턴한다.
+ * 한 번에 잡는 키는 많지 않으므로 삽입 정렬을 쓴다.
+ */
+static int collect(rwstripe_t *s, const uint64_t *keys, int n, size_t *set)
+{
+    int m = 0, j;
+    size_t x;
+
+    for (int i = 0; i < n; ++i) {
+        x = rws_stripe(s, keys[i]);
+        for (j = m; j > 0 && set[j-1] > x; --j)
+            ;
+        if (j > 0 && set[j-1] == x)
+            continue;
+        for (int k = m; k > j; --k)
+            set[k] = set[k-1];
+        set[j] = x;
+        m++;
+    }
+    return m;
+}
+
+/*
+ * keys의 n개 키가 속한 구역에 모두 reader로 들어간다. set은 n개를 담을 수 있어야 하며, 실제로 잡은 구역의
+ * 번호가 오름차순으로 담긴다. 잡은 구역의 수를 리턴하며, 나올 때는 set과 그 수를 rws_rdunlock_many()에 넘긴다.
+ * 모든 스레드가 구역 번호가 작은 것부터 잡으므로, 서로 상대가 가진 구역을 기다리는 순환이 생기지 않는다.
+ */
+int rws_rdlock_many(rwstripe_t *s, rws_thread_t *t, const uint64_t *keys, int n, size_t *set)
+{
+    int m = collect(s, keys, n, set);
+
+    for (int i = 0; i < m; ++i)
+        rw_rdlock(&s->stripes[set[i]], &t->self[set[i]]);
+    return m;
+}
+
+void rws_rdunlock_many(rwstripe_t *s, rws_thread_t *t, const size_t *set, int m)
+{
+    while (m > 0) {
+        m--;
+        rw_rdunlock(&s->stripes[set[m]], &t->self[set[m]]);
+    }
+}
+
+/*
+ * keys의 n개 키가 속한 구역에 모두 writer로 들어간다. set과 리턴값은 rws_rdlock_many()와 같다.
+ */
+int rws_wrlock_many(rwstripe_t *s, rws_thread_t *t, const uint64_t *keys, int n, size_t *set)
+{
+    int m = collect(s, keys, n, set);
+
+    for (int i = 0; i < m; ++i)
+        rw_wrlock(&s->stripes[set[i]], &t->self[set[i]]);
+    return m;
+}
+
+void rws_wrunlock_many(rwstripe_t *s, rws_thread_t *t, const size_t *set, int m)
+{
+    while (m > 0) {
+        m--;
+        rw_wrunlock(&s->stripes[set[m]], &t->self[set[m]]);
+    }
+}
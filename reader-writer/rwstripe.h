@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef RWSTRIPE_H
+#define RWSTRIPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rwlock.h"
+
+#define RWS_MAXSTRIPE 65536
+#define RWS_SUCCESS 0
+#define RWS_FAIL 4
+
+/*
+ * 큰 표를 여러 구역(stripe)으로 나누어 구역마다 reader-writer 락을 하나씩 두는 락 관리자 구조체 타입
+ *
+ * 키는 해시로 구역 하나에 대응하므로, 서로 다른 구역에 속한 키를 다루는 스레드끼리는 경쟁하지 않는다.
+ * stripes는 nstripe 개의 rwlock_t 배열이다. rwlock_t는 캐시라인 단위로 정렬되므로 이웃한 락이
+ * 캐시라인을 같이 쓰지 않는다. nstripe는 2의 거듭제곱으로 올리며, shift는 해시값의 윗 비트를 구역 번호로
+ * 쓰기 위해 버리는 비트 수이다. type은 모든 구역에 같이 쓰는 rwlock.h의 정책이며, fair_reader_writer.c와
+ * 같은 공정성이 필요하면 RW_PHASEFAIR를 준다. reader와 writer가 번갈아 들어가므로 어느 쪽도 굶지 않는다.
+ * 여러 구역을 한꺼번에 잡을 때는 언제나 구역 번호가 작은 것부터 잡으므로 교착상태가 생기지 않는다.
+ */
+typedef struct {
+    rwlock_t *stripes;          /* 구역별 reader-writer 락 */
+    size_t nstripe;             /* 구역의 수 */
+    int shift;                  /* 해시값에서 버리는 아래 비트의 수 */
+    int type;                   /* 구역 락의 정책 */
+} rwstripe_t;
+
+/*
+ * 락 관리자를 사용하는 스레드마다 하나씩 가지는 정보로, 구역마다 rw_thread_t가 하나씩 있다.
+ */
+typedef struct {
+    rw_thread_t *self;          /* 구역별 스레드 정보 */
+} rws_thread_t;
+
+int rws_init(rwstripe_t *s, size_t nstripe, int type);
+void rws_destroy(rwstripe_t *s);
+int rws_thread_init(rwstripe_t *s, rws_thread_t *t);
+void rws_thread_destroy(rws_thread_t *t);
+void rws_rdlock(rwstripe_t *s, rws_thread_t *t, uint64_t key);
+void rws_rdunlock(rwstripe_t *s, rws_thread_t *t, uint64_t key);
+void rws_wrlock(rwstripe_t *s, rws_thread_t *t, uint64_t key);
+void rws_wrunlock(rwstripe_t *s, rws_thread_t *t, uint64_t key);
+int rws_rdlock_many(rwstripe_t *s, rws_thread_t *t, const uint64_t *keys, int n, size_t *set);
+void rws_rdunlock_many(rwstripe_t *s, rws_thread_t *t, const size_t *set, int m);
+int rws_wrlock_many(rwstripe_t *s, rws_thread_t *t, const uint64_t *keys, int n, size_t *set);
+void rws_wrunlock_many(rwstripe_t *s, rws_thread_t *t, const size_t *set, int m);
+
+/*
+ * key가 속한 구역의 번호를 리턴한다. 곱셈 해시(피보나치 해싱)의 윗 비트를 쓰므로, 연속된 키도 여러 구역에
+ * 고르게 흩어진다.
+ */
+static inline size_t rws_stripe(const rwstripe_t *s, uint64_t key)
+{
+    return s->shift == 64 ? 0 : (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> s->shift);
+}
+
+#endif
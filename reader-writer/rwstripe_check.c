@@ -0,0 +1,236 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "rwstripe.h"
+
+#define NREAD 4
+#define NWRITE 4
+#define NSTRIPE 8
+#define NACCOUNT 256
+#define NKEY 4
+#define DURATION 1000
+#define STALL 3000
+#define NPOLICY 6
+#define WMARK (1 << 20)
+
+/*
+ * 락 관리자를 검사하는 프로그램
+ *
+ * 계좌 NACCOUNT 개를 적은 수의 구역으로 나누어 여러 키가 같은 구역에 몰리게 한다.
+ * writer는 키를 NKEY 개까지 골라 rws_wrlock_many()로 모두 잡은 다음, 첫 계좌에서 나머지 계좌로 돈을 옮긴다.
+ * 계좌는 금액을 a와 b에 두 번 기록하고 그 사이에 CPU를 양보하므로, 배타적이지 않은 reader나 writer는 a와 b가
+ * 다른 계좌를 보게 된다. reader는 키를 골라 rws_rdlock_many()로 잡은 다음 계좌마다 a와 b가 같은지 본다.
+ * 이와 별도로 inside[i]는 구역 i에 들어간 reader의 수에 writer 하나를 WMARK로 더한 값이므로, 들어갈 때
+ * 이미 있던 값으로 배타 조건이 깨졌는지 바로 알 수 있다. 끝나면 모든 계좌의 합이 처음과 같아야 한다.
+ * 교착상태는 일정 시간 동안 아무 스레드도 cs에 들어가지 못한 것으로 판단한다.
+ */
+typedef struct {
+    long a;                     /* 잔액 */
+    long b;                     /* 잔액의 사본 */
+} account_t;
+
+rwstripe_t table;
+account_t account[NACCOUNT];
+atomic_int inside[NSTRIPE];
+atomic_long ops, broken;
+atomic_bool alive;
+int nstripe = NSTRIPE;
+
+/*
+ * 서로 다를 수도 있는 키 n개를 고른다. 같은 키나 같은 구역에 속한 키가 섞여도 한 번만 잡혀야 한다.
+ */
+static int pick(uint64_t *keys, unsigned *seed)
+{
+    int n = 1 + rand_r(seed) % NKEY;
+
+    for (int i = 0; i < n; ++i)
+        keys[i] = rand_r(seed) % NACCOUNT;
+    return n;
+}
+
+/*
+ * 잡은 구역 set[0..m)에 들어가거나(d가 양수) 나온다(d가 음수). 들어갈 때 그 구역에 writer가 있거나,
+ * writer가 들어가는데 다른 스레드가 있으면 배타 조건이 깨진 것이다.
+ */
+static void mark(const size_t *set, int m, int d)
+{
+    int old;
+
+    for (int i = 0; i < m; ++i) {
+        old = atomic_fetch_add(&inside[set[i]], d);
+        if (d > 0 && (old >= WMARK || (d == WMARK && old != 0)))
+            atomic_fetch_add(&broken, 1);
+    }
+}
+
+void *reader(void *arg)
+{
+    unsigned seed = (unsigned)(long)arg;
+    uint64_t keys[NKEY];
+    size_t set[NKEY];
+    rws_thread_t t;
+    int n, m;
+
+    if (rws_thread_init(&table, &t) != RWS_SUCCESS)
+        pthread_exit(NULL);
+    while (alive) {
+        n = pick(keys, &seed);
+        m = rws_rdlock_many(&table, &t, keys, n, set);
+        mark(set, m, 1);
+        for (int i = 0; i < n; ++i) {
+            if (account[keys[i]].a != account[keys[i]].b)
+                atomic_fetch_add(&broken, 1);
+            sched_yield();
+        }
+        mark(set, m, -1);
+        rws_rdunlock_many(&table, &t, set, m);
+        atomic_fetch_add(&ops, 1);
+    }
+    rws_thread_destroy(&t);
+    pthread_exit(NULL);
+}
+
+void *writer(void *arg)
+{
+    unsigned seed = (unsigned)(long)arg;
+    uint64_t keys[NKEY];
+    size_t set[NKEY];
+    rws_thread_t t;
+    account_t *from, *to;
+    int n, m;
+
+    if (rws_thread_init(&table, &t) != RWS_SUCCESS)
+        pthread_exit(NULL);
+    while (alive) {
+        n = pick(keys, &seed);
+        m = rws_wrlock_many(&table, &t, keys, n, set);
+        mark(set, m, WMARK);
+        from = &account[keys[0]];
+        for (int i = 1; i < n; ++i) {
+            to = &account[keys[i]];
+            from->a -= 10;
+            to->a += 10;
+            sched_yield();
+            from->b -= 10;
+            to->b += 10;
+        }
+        mark(set, m, -WMARK);
+        rws_wrunlock_many(&table, &t, set, m);
+        atomic_fetch_add(&ops, 1);
+    }
+    rws_thread_destroy(&t);
+    pthread_exit(NULL);
+}
+
+/*
+ * 정책 type으로 duration 밀리초 동안 검사하고, 문제가 없으면 true를 리턴한다.
+ */
+static bool check(const char *name, int type, int nr, int nw, int duration)
+{
+    pthread_t tid[nr + nw];
+    long sum = 0, last = -1, now;
+    int i, stalled = 0;
+    bool ok;
+
+    if (rws_init(&table, nstripe, type) != RWS_SUCCESS) {
+        fprintf(stderr, "rws_init error\n");
+        exit(-1);
+    }
+    for (i = 0; i < NACCOUNT; ++i)
+        account[i].a = account[i].b = 1000;
+    for (i = 0; i < NSTRIPE; ++i)
+        atomic_init(&inside[i], 0);
+    atomic_store(&ops, 0);
+    atomic_store(&broken, 0);
+    atomic_store(&alive, true);
+    for (i = 0; i < nr + nw; ++i)
+        pthread_create(&tid[i], NULL, i < nr ? reader : writer, (void *)(long)(i + 1));
+    /*
+     * 10밀리초마다 진행 여부를 보다가, STALL 밀리초 동안 아무도 cs를 지나가지 못하면 교착상태로 보고 끝낸다.
+     * 스레드가 락을 잡은 채 멈춰 있으므로 기다리지 않고 바로 프로그램을 끝낸다.
+     */
+    for (i = 0; i < duration; i += 10) {
+        usleep(10000);
+        now = atomic_load(&ops);
+        stalled = now == last ? stalled + 10 : 0;
+        last = now;
+        if (stalled >= STALL) {
+            printf("%s,%ld,%ld,deadlock\n", name, now, atomic_load(&broken));
+            exit(1);
+        }
+    }
+    atomic_store(&alive, false);
+    for (i = 0; i < nr + nw; ++i)
+        pthread_join(tid[i], NULL);
+    for (i = 0; i < NACCOUNT; ++i)
+        sum += account[i].a;
+    ok = atomic_load(&broken) == 0 && sum == 1000L*NACCOUNT;
+    printf("%s,%ld,%ld,%s\n", name, atomic_load(&ops), atomic_load(&broken), ok ? "ok" : "FAIL");
+    rws_destroy(&table);
+    return ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-p reader|writer|fair|bigreader|phasefair|biased|all] [-r readers] [-w writers]"
+                    " [-n stripes] [-d milliseconds]\n", prog);
+    exit(-1);
+}
+
+/*
+ * 메인 함수는 rwlock.h의 정책마다 락 관리자를 검사하여 CSV 한 줄씩 출력한다.
+ * 하나라도 배타 조건이 깨지거나 합이 맞지 않으면 1을 리턴하고, 교착상태이면 바로 1로 끝난다.
+ */
+int main(int argc, char *argv[])
+{
+    static const char *name[NPOLICY] = {"reader", "writer", "fair", "bigreader", "phasefair", "biased"};
+    int opt, p = -1, nr = NREAD, nw = NWRITE, duration = DURATION;
+    bool ok = true;
+
+    while ((opt = getopt(argc, argv, "p:r:w:n:d:")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "all") == 0) {
+                    p = -1;
+                    break;
+                }
+                for (p = 0; p < NPOLICY && strcmp(optarg, name[p]) != 0; ++p)
+                    ;
+                if (p == NPOLICY)
+                    usage(argv[0]);
+                break;
+            case 'r':
+                nr = atoi(optarg);
+                break;
+            case 'w':
+                nw = atoi(optarg);
+                break;
+            case 'n':
+                nstripe = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (nr < 0 || nw < 0 || nr + nw == 0 || nstripe <= 0 || nstripe > NSTRIPE || duration <= 0)
+        usage(argv[0]);
+    printf("policy,ops,violations,result\n");
+    if (p >= 0)
+        ok = check(name[p], p, nr, nw, duration);
+    else
+        for (p = 0; p < NPOLICY; ++p)
+            ok = check(name[p], p, nr, nw, duration) && ok;
+    return ok ? 0 : 1;
+}
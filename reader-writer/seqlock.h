@@ -0,0 +1,91 @@
+/*
+ * Copyright 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define SEQ_SPINCOUNT 256
+#define SEQ_CACHELINE 64
+
+/*
+ * 순서 번호(sequence)로 보호하는 seqlock 구조체 타입
+ *
+ * seq는 writer가 cs에 들어갈 때와 나올 때 하나씩 올리므로, 홀수이면 writer가 데이터를 고치는 중이다.
+ * reader는 공유 메모리에 아무것도 쓰지 않는다. 시작할 때 seq를 읽고, 데이터를 복사한 다음
+ * seq를 다시 읽어서 값이 그대로이면 writer와 겹치지 않은 일관된 복사본을 얻은 것이고,
+ * 바뀌었으면 복사본을 버리고 다시 읽는다. 따라서 reader는 writer를 막지 못하고 writer는 굶주리지 않는다.
+ * 복사하는 도중에는 데이터가 깨져 있을 수 있으므로, reader는 seq_read_retry()가 false를 리턴한 다음에만
+ * 복사본을 사용해야 하며 복사하는 동안 읽은 값으로 포인터를 따라가서는 안 된다.
+ * wlock은 writer 사이의 상호배타를 위한 뮤텍스락이다.
+ */
+typedef struct {
+    _Alignas(SEQ_CACHELINE) atomic_uint seq;    /* 순서 번호, 홀수이면 writer가 cs에 있음 */
+    pthread_mutex_t wlock;                      /* writer 사이의 상호배타 */
+} seqlock_t;
+
+static inline void seqlock_init(seqlock_t *s)
+{
+    atomic_init(&s->seq, 0);
+    pthread_mutex_init(&s->wlock, NULL);
+}
+
+static inline void seqlock_destroy(seqlock_t *s)
+{
+    pthread_mutex_destroy(&s->wlock);
+}
+
+/*
+ * reader: 읽기를 시작한다. writer가 cs에 있으면 나올 때까지 기다렸다가 그때의 순서 번호를 리턴한다.
+ * writer가 오래 머무르면 CPU를 양보한다.
+ */
+static inline unsigned seq_read_begin(seqlock_t *s)
+{
+    unsigned v, spins = 0;
+
+    while ((v = atomic_load_explicit(&s->seq, memory_order_acquire)) & 1)
+        if (++spins >= SEQ_SPINCOUNT) {
+            spins = 0;
+            sched_yield();
+        }
+    return v;
+}
+
+/*
+ * reader: 읽기를 끝낸다. start 이후에 writer가 데이터를 고쳤으면 true를 리턴하므로 다시 읽어야 한다.
+ * 데이터를 읽는 것이 순서 번호를 다시 읽는 것보다 늦어지지 않도록 acquire 울타리를 먼저 친다.
+ */
+static inline bool seq_read_retry(seqlock_t *s, unsigned start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&s->seq, memory_order_relaxed) != start;
+}
+
+/*
+ * writer: 다른 writer를 배제한 다음 순서 번호를 홀수로 만들고 데이터를 고치기 시작한다.
+ * 데이터를 고치는 것이 순서 번호보다 먼저 보이지 않도록 release 울타리를 친다.
+ */
+static inline void seq_write_lock(seqlock_t *s)
+{
+    pthread_mutex_lock(&s->wlock);
+    atomic_store_explicit(&s->seq, atomic_load_explicit(&s->seq, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/*
+ * writer: 순서 번호를 다시 짝수로 만들어 고친 데이터를 발행하고 다른 writer에게 넘겨준다.
+ */
+static inline void seq_write_unlock(seqlock_t *s)
+{
+    atomic_store_explicit(&s->seq, atomic_load_explicit(&s->seq, memory_order_relaxed) + 1,
+                          memory_order_release);
+    pthread_mutex_unlock(&s->wlock);
+}
+
+#endif
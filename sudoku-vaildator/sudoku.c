@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <pthread.h>
+#include "sudoku_kernel.h"
 
 // 서브그리드를 식별하기 위한 구조체
 typedef struct{
@@ -34,23 +35,10 @@ void *check_rows(void *arg)
 {
     // 여기를 완성하세요
     for (int i = 0; i < 9; i++){
-        int before[9] = {0,}; // 현재 숫자가 이전에 나왔는지를 체크하는 배열
-        int is_valid = 1; // for loop를 빠져나온 뒤, i번째 행이 올바른지 판단할 때 사용하는 변수
-        for (int j = 0; j < 9; j++){
-            int num = sudoku[i][j]; 
-            if (num > 9 || num < 1 || before[num - 1] > 0){ // 현재 숫자가 valid 하지 않음
-                // is_valid를 0으로 변경 후, for loop 빠져나옴
-                is_valid = 0; 
-                break; 
-            } 
-            else {
-                before[num - 1]++; // 현재 숫자를 배열의 index로 사용
-            }
-        }
-        if(is_valid == 1) // i번째 행이 올바름
-            valid[0][i] = 1; 
-        else // i번째 행이 올바르지 않음
-            valid[0][i] = 0; 
+        unsigned mask = 0; // i번째 행에 나온 숫자의 비트를 모은 마스크
+        for (int j = 0; j < 9; j++)
+            mask |= sk_cell(sudoku[i][j]); // 범위를 벗어난 숫자는 비트를 세우지 않음
+        valid[0][i] = (mask == SK_FULL); // 1부터 9까지 모두 나왔으면 i번째 행이 올바름
     }
     // 모든 행 체크 완료
     pthread_exit(NULL); 
@@ -64,23 +52,10 @@ void *check_columns(void *arg)
 {
     // 여기를 완성하세요
     for (int j = 0; j < 9; j++){
-        int before[9] = {0,}; // 현재 숫자가 이전에 나왔는지를 체크하는 배열
-        int is_valid = 1; // for loop를 빠져나온 뒤, j번째 열이 올바른지 판단할 때 사용하는 변수
-        for (int i = 0; i < 9; i++){
-            int num = sudoku[i][j];
-            if (num > 9 || num < 1 || before[num - 1] > 0){ // 현재 숫자가 valid 하지 않음
-                // is_valid를 0으로 변경 후, for loop 빠져나옴
-                is_valid = 0;
-                break; 
-            } 
-            else {
-                before[num - 1]++; // 현재 숫자를 배열의 index로 사용
-            }
-        }
-        if(is_valid == 1) // j번째 열이 올바름
-            valid[1][j] = 1; 
-        else // j번째 열이 올바르지 않음
-            valid[1][j] = 0; 
+        unsigned mask = 0; // j번째 열에 나온 숫자의 비트를 모은 마스크
+        for (int i = 0; i < 9; i++)
+            mask |= sk_cell(sudoku[i][j]); // 범위를 벗어난 숫자는 비트를 세우지 않음
+        valid[1][j] = (mask == SK_FULL); // 1부터 9까지 모두 나왔으면 j번째 열이 올바름
     }
     // 모든 열 체크 완료
     pthread_exit(NULL);
@@ -98,22 +73,12 @@ void *check_subgrid(void *arg)
     int row = args -> row;
     int col = args -> col;
     int k = args -> idx; // 서브그리드의 index
-    int before[9] = {0,}; // 현재 숫자가 이전에 나왔는지를 체크하는 배열
-    for (int i = row; i < row + 3; i++){
-        for (int j = col; j < col + 3; j++){
-            int num = sudoku[i][j];
-            if (num > 9 || num < 1 || before[num - 1] > 0){ // 현재 숫자가 valid 하지 않음
-                // k번 서브그리드가 올바르지 않음 -> valid[2][k]에 0을 기록후, 스레드 종료
-                valid[2][k] = 0;
-                pthread_exit(NULL);
-            } 
-            else {
-                before[num - 1]++; // 현재 숫자를 배열의 index로 사용
-            }
-        }
-    }
-    // k번 서브그리드가 올바름
-    valid[2][k] = 1; 
+    unsigned mask = 0; // k번 서브그리드에 나온 숫자의 비트를 모은 마스크
+    for (int i = row; i < row + 3; i++)
+        for (int j = col; j < col + 3; j++)
+            mask |= sk_cell(sudoku[i][j]); // 범위를 벗어난 숫자는 비트를 세우지 않음
+    // 1부터 9까지 모두 나왔으면 k번 서브그리드가 올바름
+    valid[2][k] = (mask == SK_FULL);
     pthread_exit(NULL);
 }
 
@@ -125,7 +90,7 @@ void *check_subgrid(void *arg)
 void check_sudoku(void)
 {
     int i, j;
-    int gid[9];
+    subgrid_args gid[9]; // 서브그리드 스레드의 인자, 스레드를 조인할 때까지 남아 있음
     pthread_t rowtid, coltid, subgridtid[9];
     
     /*
@@ -155,11 +120,11 @@ void check_sudoku(void)
     int k = 0; // 서브그리드의 index를 나타내는 변수
     for (i = 0; i <= 6; i = i + 3){
         for (j = 0; j <= 6; j = j + 3){
-            subgrid_args *arg = (subgrid_args *)malloc(sizeof(subgrid_args));
-            arg -> idx = k;
-            arg -> row = i;
-            arg -> col = j;
-            pthread_create(&subgridtid[k++], NULL, check_subgrid, arg);
+            gid[k].idx = k;
+            gid[k].row = i;
+            gid[k].col = j;
+            pthread_create(&subgridtid[k], NULL, check_subgrid, &gid[k]);
+            k++;
         }
     }
     /*
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdatomic.h>
+#include "sudoku_batch.h"
+
+/*
+ * 한 번의 sudoku_batch() 호출을 나타내는 구조체 타입
+ *
+ * next는 아직 아무도 가져가지 않은 첫 덩어리의 번호이며, 일꾼과 부른 스레드가 원자적으로 올리며 가져간다.
+ * left는 풀에 맡겼지만 아직 끝나지 않은 작업의 수이다. 작업은 부른 스레드의 스택에 있는 이 구조체를 쓰므로,
+ * 부른 스레드는 덩어리가 모두 끝났더라도 left가 0이 될 때까지 기다렸다가 돌아간다.
+ */
+typedef struct {
+    const uint8_t *boards;      /* 검증할 퍼즐 */
+    uint32_t *units;            /* 검증 결과 */
+    size_t n;                   /* 퍼즐의 수 */
+    size_t nchunk;              /* 덩어리의 수 */
+    atomic_size_t next;         /* 다음에 가져갈 덩어리 */
+    int left;                   /* 끝나지 않은 작업의 수 */
+    pthread_mutex_t mutex;      /* left를 보호하는 락 */
+    pthread_cond_t done;        /* left가 0이 되기를 기다리는 곳 */
+} batch_t;
+
+static void validate(const uint8_t *boards, uint32_t *units, size_t from, size_t to)
+{
+    for (size_t i = from; i < to; ++i)
+        units[i] = sk_units(boards + i*SK_NCELL);
+}
+
+/*
+ * 남은 덩어리가 없을 때까지 하나씩 가져가서 검증한다.
+ */
+static void drain(batch_t *b)
+{
+    size_t c, from, to;
+
+    while ((c = atomic_fetch_add_explicit(&b->next, 1, memory_order_relaxed)) < b->nchunk) {
+        from = c*SB_CHUNK;
+        to = from + SB_CHUNK < b->n ? from + SB_CHUNK : b->n;
+        validate(b->boards, b->units, from, to);
+    }
+}
+
+/*
+ * 풀의 일꾼이 실행하는 작업 함수이다. 덩어리를 다 처리하면 끝났음을 알린다.
+ */
+static void batch_task(void *param)
+{
+    batch_t *b = (batch_t *)param;
+
+    drain(b);
+    pthread_mutex_lock(&b->mutex);
+    if (--b->left == 0)
+        pthread_cond_signal(&b->done);
+    pthread_mutex_unlock(&b->mutex);
+}
+
+int sudoku_batch(pthread_pool_t *pool, const uint8_t *boards, size_t n, uint32_t *units)
+{
+    batch_t b;
+    size_t ntask;
+
+    if (pool == NULL || n < SB_SERIAL) {
+        validate(boards, units, 0, n);
+        return SB_SUCCESS;
+    }
+    b.boards = boards;
+    b.units = units;
+    b.n = n;
+    b.nchunk = (n + SB_CHUNK - 1) / SB_CHUNK;
+    atomic_init(&b.next, 0);
+    b.left = 0;
+    pthread_mutex_init(&b.mutex, NULL);
+    pthread_cond_init(&b.done, NULL);
+    /*
+     * 부른 스레드도 덩어리 하나를 맡으므로 일꾼에게는 많아야 덩어리 수보다 하나 적은 작업을 맡긴다.
+     * 대기열이 차서 맡기지 못한 몫은 부른 스레드가 처리한다.
+     */
+    ntask = b.nchunk - 1 < (size_t)pool->bee_size ? b.nchunk - 1 : (size_t)pool->bee_size;
+    for (size_t i = 0; i < ntask; ++i) {
+        pthread_mutex_lock(&b.mutex);
+        b.left++;
+        pthread_mutex_unlock(&b.mutex);
+        if (pthread_pool_submit(pool, batch_task, &b, POOL_NOWAIT) != POOL_SUCCESS) {
+            pthread_mutex_lock(&b.mutex);
+            b.left--;
+            pthread_mutex_unlock(&b.mutex);
+            break;
+        }
+    }
+    drain(&b);
+    pthread_mutex_lock(&b.mutex);
+    while (b.left > 0)
+        pthread_cond_wait(&b.done, &b.mutex);
+    pthread_mutex_unlock(&b.mutex);
+    pthread_mutex_destroy(&b.mutex);
+    pthread_cond_destroy(&b.done);
+    return SB_SUCCESS;
+}
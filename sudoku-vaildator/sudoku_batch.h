@@ -0,0 +1,27 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef SUDOKU_BATCH_H
+#define SUDOKU_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../threadpool/pthread_pool.h"
+#include "sudoku_kernel.h"
+
+#define SB_SERIAL 1024
+#define SB_CHUNK 2048
+#define SB_SUCCESS 0
+
+/*
+ * 퍼즐 n개를 한꺼번에 검증한다.
+ *
+ * 퍼즐은 boards에 81바이트씩 이어서 놓이며, i번 퍼즐의 검증 결과(sk_units()의 27비트 마스크)를 units[i]에
+ * 기록한다. 퍼즐마다 스레드를 만드는 대신 이미 만들어 둔 스레드풀의 일꾼이 SB_CHUNK 개씩 연속된 퍼즐
+ * 덩어리를 가져가서 검증하며, 부른 스레드도 기다리는 동안 같이 덩어리를 가져간다.
+ * pool이 NULL이거나 n이 SB_SERIAL보다 작으면 풀에 맡기는 비용이 더 크므로 부른 스레드 혼자 검증한다.
+ */
+int sudoku_batch(pthread_pool_t *pool, const uint8_t *boards, size_t n, uint32_t *units);
+
+#endif
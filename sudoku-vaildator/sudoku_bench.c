@@ -0,0 +1,137 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "sudoku_batch.h"
+
+#define NBOARD 1000000
+#define NTHREAD 4
+#define NREPEAT 5
+
+/*
+ * 퍼즐을 만들 때 쓰는 기본 스도쿠 퍼즐로, sudoku.c의 것과 같다.
+ */
+static const uint8_t base[SK_NCELL] = {
+    6,3,9,8,4,1,2,7,5, 7,2,4,9,5,3,1,6,8, 1,8,5,7,2,6,3,9,4,
+    2,5,6,1,3,7,4,8,9, 4,9,1,5,8,2,6,3,7, 8,7,3,4,6,9,5,2,1,
+    5,4,2,3,9,8,7,1,6, 3,1,8,6,7,5,9,4,2, 9,6,7,2,1,4,8,5,3
+};
+
+static inline long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/*
+ * 기본 퍼즐의 숫자를 바꿔 쓰고 띠 안의 행과 기둥 안의 열을 섞어서 올바른 퍼즐 g를 만든다.
+ * 이 변환은 퍼즐의 올바름을 유지한다. 그 다음 절반의 퍼즐은 가까운 두 칸을 맞바꾸므로, 두 값이 다르면 깨진다.
+ */
+static void generate(uint8_t *g, unsigned *seed)
+{
+    uint8_t digit[10], row[9], col[9], t;
+    int i, j, k;
+
+    for (i = 0; i < 10; ++i)
+        digit[i] = i;
+    for (i = 9; i > 1; --i) {
+        j = 1 + rand_r(seed) % i;
+        t = digit[i]; digit[i] = digit[j]; digit[j] = t;
+    }
+    for (i = 0; i < 9; ++i)
+        row[i] = col[i] = i;
+    for (k = 0; k < 9; k += 3)
+        for (i = 2; i > 0; --i) {
+            j = rand_r(seed) % (i+1);
+            t = row[k+i]; row[k+i] = row[k+j]; row[k+j] = t;
+            j = rand_r(seed) % (i+1);
+            t = col[k+i]; col[k+i] = col[k+j]; col[k+j] = t;
+        }
+    for (i = 0; i < 9; ++i)
+        for (j = 0; j < 9; ++j)
+            g[i*9+j] = digit[base[row[i]*9 + col[j]]];
+    if (rand_r(seed) & 1) {
+        i = rand_r(seed) % SK_NCELL;
+        j = (i + 3 + rand_r(seed) % 6) % SK_NCELL;
+        t = g[i]; g[i] = g[j]; g[j] = t;
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-n boards] [-t threads (0: no pool)] [-r repeat] [-s (scalar kernel check)]\n", prog);
+    exit(-1);
+}
+
+/*
+ * 퍼즐 n개를 만들어 두고 sudoku_batch()로 repeat 번 검증하여 초당 검증한 퍼즐 수를 CSV로 출력한다.
+ * -s를 주면 SIMD 커널의 결과를 sk_units_scalar()와 비교한다.
+ */
+int main(int argc, char *argv[])
+{
+    int opt, nthread = NTHREAD, repeat = NREPEAT, check = 0;
+    long n = NBOARD, t, best = 0, valid = 0, bad = 0;
+    unsigned seed = 1;
+    uint8_t *boards;
+    uint32_t *units;
+    pthread_pool_t pool;
+
+    while ((opt = getopt(argc, argv, "n:t:r:s")) != -1) {
+        switch (opt) {
+            case 'n':
+                n = atol(optarg);
+                break;
+            case 't':
+                nthread = atoi(optarg);
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 's':
+                check = 1;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (n <= 0 || nthread < 0 || nthread > POOL_MAXBSIZE || repeat <= 0)
+        usage(argv[0]);
+    boards = (uint8_t *)malloc((size_t)n * SK_NCELL);
+    units = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (boards == NULL || units == NULL) {
+        fprintf(stderr, "malloc error\n");
+        exit(-1);
+    }
+    for (long i = 0; i < n; ++i)
+        generate(boards + i*SK_NCELL, &seed);
+    if (nthread > 0 && pthread_pool_init(&pool, nthread, nthread) != POOL_SUCCESS) {
+        fprintf(stderr, "pthread_pool_init error\n");
+        exit(-1);
+    }
+    for (int r = 0; r < repeat; ++r) {
+        t = now_ns();
+        sudoku_batch(nthread > 0 ? &pool : NULL, boards, n, units);
+        t = now_ns() - t;
+        if (best == 0 || t < best)
+            best = t;
+    }
+    for (long i = 0; i < n; ++i) {
+        valid += units[i] == SK_ALL;
+        if (check && units[i] != sk_units_scalar(boards + i*SK_NCELL))
+            bad++;
+    }
+    if (nthread > 0)
+        pthread_pool_shutdown(&pool);
+    printf("threads,boards,simd,boards_per_s,valid,mismatch\n");
+    printf("%d,%ld,%d,%.0f,%ld,%ld\n", nthread, n, sk_simd(), n * 1e9 / best, valid, bad);
+    free(boards);
+    free(units);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include "sudoku_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SK_HAVE_AVX2 1
+#endif
+
+/*
+ * 행, 열, 서브그리드의 마스크를 검증 결과 마스크로 모은다.
+ */
+static uint32_t collect(const unsigned row[9], const unsigned col[9], const unsigned grid[9])
+{
+    uint32_t v = 0;
+
+    for (int i = 0; i < 9; ++i) {
+        v |= (uint32_t)(row[i] == SK_FULL) << (SK_ROWS + i);
+        v |= (uint32_t)(col[i] == SK_FULL) << (SK_COLS + i);
+        v |= (uint32_t)(grid[i] == SK_FULL) << (SK_GRIDS + i);
+    }
+    return v;
+}
+
+/*
+ * 81바이트 퍼즐 g의 27개 unit을 하나씩 검증한다. 칸마다 마스크를 하나 만들어 세 unit에 OR한다.
+ */
+uint32_t sk_units_scalar(const uint8_t *g)
+{
+    unsigned row[9] = {0,}, col[9] = {0,}, grid[9] = {0,}, m;
+
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 9; ++j) {
+            m = sk_cell(g[i*9+j]);
+            row[i] |= m;
+            col[j] |= m;
+            grid[(i/3)*3 + j/3] |= m;
+        }
+    return collect(row, col, grid);
+}
+
+/*
+ * sudoku.c처럼 int 배열로 된 퍼즐을 검증한다. 방법은 sk_units_scalar()와 같다.
+ */
+uint32_t sk_units_int(const int g[9][9])
+{
+    unsigned row[9] = {0,}, col[9] = {0,}, grid[9] = {0,}, m;
+
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 9; ++j) {
+            m = sk_cell(g[i][j]);
+            row[i] |= m;
+            col[j] |= m;
+            grid[(i/3)*3 + j/3] |= m;
+        }
+    return collect(row, col, grid);
+}
+
+#ifdef SK_HAVE_AVX2
+/*
+ * AVX2로 27개 unit을 한꺼번에 검증한다.
+ * 행 하나를 16비트 레인 16개에 놓는다(레인 0~8이 칸). 칸의 값은 15로 자른 다음 pshufb 표 두 개로
+ * 마스크의 아래 바이트(1~8)와 위 바이트(9)를 찾아 합친다. 범위를 벗어난 값은 두 표에서 모두 0이다.
+ *   열: 아홉 행 벡터를 OR하면 레인 j가 j번 열의 마스크이다. 세 행씩 OR한 띠(band)를 먼저 만들어 다시 쓴다.
+ *   서브그리드: 띠를 레인 1개, 2개만큼 민 것과 OR하면 레인 0, 3, 6이 그 띠의 서브그리드이다.
+ *   행: 0~7번 행은 unpack과 OR로 전치하면서 줄여서 레인 i에 i번 행의 마스크를 얻고, 8번 행은 따로 줄인다.
+ * 마지막 행은 퍼즐 밖을 읽지 않도록 7바이트 앞에서 읽어 민다.
+ */
+__attribute__((target("avx2")))
+static uint32_t sk_units_avx2(const uint8_t *g)
+{
+    const __m256i lo = _mm256_setr_epi8(0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0,
+                                        0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i hi = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0,
+                                        0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0);
+    const __m256i lanes = _mm256_setr_epi16(-1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i full = _mm256_set1_epi16(SK_FULL);
+    __m256i m[9], p[4], q[2], band, up, grid, col, t;
+    __m128i x, rows, last;
+    uint32_t v, gm;
+
+    for (int i = 0; i < 9; ++i) {
+        x = i < 8 ? _mm_loadu_si128((const __m128i *)(g + i*9))
+                  : _mm_srli_si128(_mm_loadu_si128((const __m128i *)(g + SK_NCELL - 16)), 7);
+        t = _mm256_cvtepu8_epi16(_mm_min_epu8(x, _mm_set1_epi8(15)));
+        t = _mm256_or_si256(_mm256_shuffle_epi8(lo, t), _mm256_slli_epi16(_mm256_shuffle_epi8(hi, t), 8));
+        m[i] = _mm256_and_si256(t, lanes);
+    }
+    /*
+     * 띠마다 서브그리드를 구하고 띠를 모아 열을 구한다.
+     */
+    col = _mm256_setzero_si256();
+    gm = 0;
+    for (int b = 0; b < 3; ++b) {
+        band = _mm256_or_si256(_mm256_or_si256(m[b*3], m[b*3+1]), m[b*3+2]);
+        col = _mm256_or_si256(col, band);
+        up = _mm256_permute2x128_si256(band, band, 0x81);
+        grid = _mm256_or_si256(band, _mm256_or_si256(_mm256_alignr_epi8(up, band, 2),
+                                                     _mm256_alignr_epi8(up, band, 4)));
+        v = _mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(_mm256_castsi256_si128(grid),
+                                                              _mm256_castsi256_si128(full)),
+                                              _mm_setzero_si128()));
+        gm |= ((v & 1) | ((v >> 2) & 2) | ((v >> 4) & 4)) << (b*3);
+    }
+    t = _mm256_cmpeq_epi16(col, full);
+    v = (_mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1))) &
+         SK_FULL) << SK_COLS;
+    /*
+     * 0~7번 행을 전치하면서 줄인다. 256비트 unpack은 128비트 반쪽마다 따로 일하므로, 아래 반쪽은 0~7번 칸을,
+     * 위 반쪽은 8번 칸을 줄인 것이 되어 마지막에 두 반쪽을 OR한다.
+     */
+    for (int i = 0; i < 4; ++i)
+        p[i] = _mm256_or_si256(_mm256_unpacklo_epi16(m[i*2], m[i*2+1]), _mm256_unpackhi_epi16(m[i*2], m[i*2+1]));
+    for (int i = 0; i < 2; ++i)
+        q[i] = _mm256_or_si256(_mm256_unpacklo_epi32(p[i*2], p[i*2+1]), _mm256_unpackhi_epi32(p[i*2], p[i*2+1]));
+    t = _mm256_or_si256(_mm256_unpacklo_epi64(q[0], q[1]), _mm256_unpackhi_epi64(q[0], q[1]));
+    rows = _mm_or_si128(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+    last = _mm_or_si128(_mm256_castsi256_si128(m[8]), _mm256_extracti128_si256(m[8], 1));
+    last = _mm_or_si128(last, _mm_srli_si128(last, 8));
+    last = _mm_or_si128(last, _mm_srli_si128(last, 4));
+    last = _mm_or_si128(last, _mm_srli_si128(last, 2));
+    v |= (_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(rows, _mm256_castsi256_si128(full)),
+                                            _mm_cmpeq_epi16(last, _mm256_castsi256_si128(full)))) &
+          SK_FULL) << SK_ROWS;
+    return v | gm << SK_GRIDS;
+}
+#endif
+
+/*
+ * 이 CPU에서 SIMD 커널을 쓸 수 있으면 1을 리턴한다.
+ */
+int sk_simd(void)
+{
+#ifdef SK_HAVE_AVX2
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * 81바이트 퍼즐 g를 검증한다. CPU가 AVX2를 지원하면 SIMD 커널을, 아니면 sk_units_scalar()를 쓴다.
+ */
+uint32_t sk_units(const uint8_t *g)
+{
+#ifdef SK_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return sk_units_avx2(g);
+#endif
+    return sk_units_scalar(g);
+}
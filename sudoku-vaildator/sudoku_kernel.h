@@ -0,0 +1,42 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#ifndef SUDOKU_KERNEL_H
+#define SUDOKU_KERNEL_H
+
+#include <stdint.h>
+
+#define SK_NCELL 81
+#define SK_NUNIT 27
+#define SK_FULL 0x1FF
+#define SK_ALL 0x7FFFFFF
+#define SK_ROWS 0
+#define SK_COLS 9
+#define SK_GRIDS 18
+
+/*
+ * 스도쿠 검증 커널
+ *
+ * 행, 열, 3x3 서브그리드(unit) 하나를 9비트 마스크로 나타낸다. 칸의 값이 v(1~9)이면 v-1번 비트를 세우고,
+ * 범위를 벗어난 값은 아무 비트도 세우지 않는다. unit의 아홉 칸의 마스크를 OR한 값이 SK_FULL(0x1FF)이면
+ * 아홉 칸에 1부터 9까지 모두 한 번씩 나온 것이므로 그 unit은 올바르다. 칸마다 분기하거나 개수를 세는
+ * 배열을 둘 필요가 없다.
+ * 퍼즐은 행 우선으로 놓인 81바이트 배열이다. 검증 결과는 27비트 마스크로 리턴하며, i번 행은 SK_ROWS+i,
+ * j번 열은 SK_COLS+j, k번 서브그리드는 SK_GRIDS+k 번 비트가 서면 올바르다. 퍼즐 전체가 올바르면 SK_ALL이다.
+ */
+
+/*
+ * 칸의 값 v를 9비트 마스크로 바꾼다. 범위를 벗어난 값은 0이다.
+ */
+static inline unsigned sk_cell(int v)
+{
+    return (unsigned)(v - 1) < 9 ? 1u << (v - 1) : 0;
+}
+
+uint32_t sk_units(const uint8_t *g);
+uint32_t sk_units_scalar(const uint8_t *g);
+uint32_t sk_units_int(const int g[9][9]);
+int sk_simd(void);
+
+#endif
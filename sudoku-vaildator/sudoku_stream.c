@@ -0,0 +1,399 @@
+/*
+ * Copyright 2021, 2022. Heekuck Oh, all rights reserved
+ * 이 프로그램은 한양대학교 ERICA 소프트웨어학부 재학생을 위한 교육용으로 제작되었습니다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sudoku_batch.h"
+
+#define SS_BATCH 65536
+#define SS_NSLOT 4
+#define SS_BLOCK (1 << 22)
+#define NTHREAD 4
+#define FMT_TEXT 0
+#define FMT_BINARY 1
+#define OUT_BITMAP 0
+#define OUT_MASKS 1
+#define OUT_NONE 2
+
+/*
+ * 스트리밍 스도쿠 검증기
+ *
+ * 파일이나 표준입력에서 퍼즐을 읽어 검증한다. 입력 형식은 두 가지이다.
+ *   text: 한 줄에 퍼즐 하나로 81개의 문자가 행 우선으로 놓인다. '1'~'9'가 아닌 문자('0', '.' 등)는 빈칸이므로
+ *   그 칸이 속한 unit은 올바르지 않다. 빈 줄과 '#'으로 시작하는 줄은 건너뛰며, 길이가 81이 아닌 줄은
+ *   잘못된 줄로 세고 빈 퍼즐로 검증하여 출력의 퍼즐 번호가 입력 줄과 어긋나지 않게 한다.
+ *   binary: 퍼즐마다 81바이트로 칸의 값(1~9)이 행 우선으로 놓인다.
+ * 일반 파일은 mmap()하고, 파이프 같은 나머지 입력은 SS_BLOCK 바이트씩 read()한다. binary를 mmap한 경우에는
+ * 퍼즐을 복사하지 않고 매핑된 곳을 그대로 검증한다. 어느 경우든 퍼즐마다 메모리를 할당하지 않는다.
+ *
+ * 읽는 스레드(reader)와 검증하는 메인 스레드가 SS_NSLOT 개의 슬롯을 돌려 쓰는 파이프라인을 이룬다.
+ * reader는 빈 슬롯에 SS_BATCH 개까지 퍼즐을 채워 넘기고, 메인 스레드는 sudoku_batch()로 스레드풀에서
+ * 슬롯을 검증한 다음 결과를 출력하고 슬롯을 돌려준다. 슬롯은 bounded buffer처럼 두 세마포로 주고받는다.
+ * 출력은 퍼즐마다 1비트(올바르면 1, 바이트 안에서는 아래 비트부터)인 비트맵이거나, 퍼즐마다 27비트 unit
+ * 마스크를 호스트 바이트 순서의 uint32_t로 쓴 것이다. 통계는 표준에러로 출력한다.
+ */
+
+/*
+ * 파이프라인의 슬롯 하나
+ *
+ * boards는 검증할 퍼즐로, 풀어 놓은 buf이거나 mmap한 입력의 한 부분이다. n이 0인 슬롯은 입력의 끝을 뜻한다.
+ * unmap이 NULL이 아니면 이 슬롯이 그 매핑을 쓰는 마지막 슬롯이므로, 검증한 다음 매핑을 푼다.
+ */
+typedef struct {
+    const uint8_t *boards;      /* 검증할 퍼즐 */
+    size_t n;                   /* 퍼즐의 수 */
+    uint8_t *buf;               /* 텍스트나 읽은 binary를 풀어 놓는 곳 */
+    uint32_t *units;            /* 검증 결과 */
+    void *unmap;                /* 검증한 다음 풀 매핑 */
+    size_t unmap_len;           /* 풀 매핑의 길이 */
+} slot_t;
+
+slot_t slot[SS_NSLOT];
+sem_t filled, empty;            /* 채워진 슬롯과 빈 슬롯의 수 */
+int in, out;                    /* reader가 채울 슬롯과 메인 스레드가 검증할 슬롯 */
+slot_t *cur;                    /* reader가 채우고 있는 슬롯 */
+int format = FMT_TEXT;
+long nmalformed, nbytes;        /* reader만 쓴다 */
+
+/*
+ * reader: 퍼즐 하나를 채울 자리를 리턴한다. 채우고 있는 슬롯이 없으면 빈 슬롯을 기다려서 가져온다.
+ */
+static uint8_t *board_slot(void)
+{
+    if (cur == NULL) {
+        sem_wait(&empty);
+        cur = &slot[in];
+        cur->boards = cur->buf;
+        cur->n = 0;
+        cur->unmap = NULL;
+    }
+    return cur->buf + cur->n*SK_NCELL;
+}
+
+/*
+ * reader: 채우고 있는 슬롯에 퍼즐이 있으면 메인 스레드에게 넘긴다.
+ */
+static void publish(void)
+{
+    if (cur == NULL || cur->n == 0)
+        return;
+    in = (in + 1) % SS_NSLOT;
+    cur = NULL;
+    sem_post(&filled);
+}
+
+/*
+ * reader: board_slot()의 자리를 다 채웠다. 슬롯이 차면 넘긴다.
+ */
+static void board_done(void)
+{
+    if (++cur->n == SS_BATCH)
+        publish();
+}
+
+/*
+ * reader: 텍스트 p[0..len)에서 완성된 줄을 퍼즐로 풀고 소비한 바이트 수를 리턴한다.
+ * last가 false이면 줄바꿈이 없는 마지막 조각은 다음 블록과 이어 붙이도록 남긴다.
+ * 문자에서 '0'을 빼기만 하므로 '1'~'9'가 아닌 문자는 모두 검증 커널이 빈칸으로 보는 값이 된다.
+ */
+static size_t parse_text(const uint8_t *p, size_t len, bool last)
+{
+    const uint8_t *s = p, *end = p + len, *nl;
+    size_t n;
+    uint8_t *g;
+
+    while (s < end) {
+        nl = (const uint8_t *)memchr(s, '\n', end - s);
+        if (nl == NULL && !last)
+            break;
+        n = (nl != NULL ? nl : end) - s;
+        if (n > 0 && s[n-1] == '\r')
+            n--;
+        if (n > 0 && s[0] != '#') {
+            g = board_slot();
+            if (n == SK_NCELL)
+                for (int k = 0; k < SK_NCELL; ++k)
+                    g[k] = s[k] - '0';
+            else {
+                memset(g, 0, SK_NCELL);
+                nmalformed++;
+            }
+            board_done();
+        }
+        s = nl != NULL ? nl + 1 : end;
+    }
+    return s - p;
+}
+
+/*
+ * reader: binary p[0..len)에서 완성된 퍼즐을 슬롯으로 복사하고 소비한 바이트 수를 리턴한다.
+ */
+static size_t parse_binary(const uint8_t *p, size_t len, bool last)
+{
+    size_t done = 0;
+
+    while (len - done >= SK_NCELL) {
+        memcpy(board_slot(), p + done, SK_NCELL);
+        board_done();
+        done += SK_NCELL;
+    }
+    if (last && done < len) {
+        fprintf(stderr, "warning: %zu trailing bytes ignored\n", len - done);
+        done = len;
+    }
+    return done;
+}
+
+static size_t parse(const uint8_t *p, size_t len, bool last)
+{
+    return format == FMT_TEXT ? parse_text(p, len, last) : parse_binary(p, len, last);
+}
+
+/*
+ * reader: 매핑한 binary 파일을 복사하지 않고 SS_BATCH 개씩 슬롯에 가리키게 한다.
+ * 매핑은 마지막 슬롯이 검증된 다음에 풀린다.
+ */
+static void feed_mapped_binary(const uint8_t *map, size_t len)
+{
+    size_t n = len / SK_NCELL, k;
+
+    publish();
+    for (size_t i = 0; i < n; i += k) {
+        k = n - i < SS_BATCH ? n - i : SS_BATCH;
+        board_slot();
+        cur->boards = map + i*SK_NCELL;
+        cur->n = k;
+        if (i + k == n) {
+            cur->unmap = (void *)map;
+            cur->unmap_len = len;
+        }
+        publish();
+    }
+    if (n == 0)
+        munmap((void *)map, len);
+    if (len % SK_NCELL != 0)
+        fprintf(stderr, "warning: %zu trailing bytes ignored\n", len % SK_NCELL);
+}
+
+/*
+ * reader: 파일 기술자 fd의 입력을 모두 읽는다. 일반 파일이면 mmap()하고, 아니면 블록 단위로 read()한다.
+ * 블록 끝에 걸친 줄이나 퍼즐은 버퍼 앞으로 옮겨서 다음 블록과 이어 붙인다. 블록보다 긴 줄은 앞부분을 잘라서
+ * 잘못된 줄 하나로 세고, 나머지는 다음 줄바꿈까지 버려서 출력의 퍼즐 번호가 입력 줄과 어긋나지 않게 한다.
+ */
+static void feed(int fd, const char *name, uint8_t *block)
+{
+    struct stat st;
+    uint8_t *map;
+    size_t have = 0, used;
+    ssize_t r;
+    bool skip = false;
+    uint8_t *nl;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = (uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            nbytes += st.st_size;
+            if (format == FMT_BINARY)
+                feed_mapped_binary(map, st.st_size);
+            else {
+                parse_text(map, st.st_size, true);
+                munmap(map, st.st_size);
+            }
+            return;
+        }
+    }
+    while (1) {
+        r = read(fd, block + have, SS_BLOCK - have);
+        if (r < 0) {
+            perror(name);
+            break;
+        }
+        nbytes += r;
+        have += r;
+        /*
+         * 잘라 낸 줄의 나머지를 줄바꿈까지 버린다.
+         */
+        if (skip) {
+            nl = (uint8_t *)memchr(block, '\n', have);
+            used = nl != NULL ? (size_t)(nl - block) + 1 : have;
+            skip = nl == NULL;
+            memmove(block, block + used, have - used);
+            have -= used;
+        }
+        used = parse(block, have, r == 0);
+        if (used == 0 && have == SS_BLOCK) {
+            used = parse(block, have, true);
+            skip = true;
+        }
+        memmove(block, block + used, have - used);
+        have -= used;
+        if (r == 0)
+            break;
+    }
+}
+
+/*
+ * reader 스레드는 인자로 받은 파일을 차례로 읽어 슬롯을 채우고, 끝나면 n이 0인 슬롯을 넘긴다.
+ * 파일이 없으면 표준입력을 읽는다.
+ */
+static void *reader(void *arg)
+{
+    char **files = (char **)arg;
+    uint8_t *block = (uint8_t *)malloc(SS_BLOCK);
+    int fd;
+
+    if (block == NULL) {
+        fprintf(stderr, "malloc error\n");
+        exit(-1);
+    }
+    if (files[0] == NULL)
+        feed(STDIN_FILENO, "stdin", block);
+    for (; files[0] != NULL; ++files) {
+        if ((fd = open(files[0], O_RDONLY)) < 0) {
+            perror(files[0]);
+            continue;
+        }
+        feed(fd, files[0], block);
+        close(fd);
+    }
+    publish();
+    board_slot();
+    in = (in + 1) % SS_NSLOT;
+    cur = NULL;
+    sem_post(&filled);
+    free(block);
+    pthread_exit(NULL);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-f text|binary] [-o bitmap|masks|none] [-t threads (0: no pool)] [file ...]\n", prog);
+    exit(-1);
+}
+
+static inline long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/*
+ * 메인 스레드는 reader를 만든 다음 채워진 슬롯을 차례로 검증하고 결과를 출력한다.
+ * 비트맵은 슬롯 경계와 상관없이 퍼즐 번호 순서대로 이어지도록, 아직 채우지 못한 바이트를 다음 슬롯으로 넘긴다.
+ */
+int main(int argc, char *argv[])
+{
+    int opt, output = OUT_BITMAP, nthread = NTHREAD, nbit = 0;
+    long nboard = 0, nvalid = 0, t;
+    uint8_t *bitmap, acc = 0;
+    size_t nbyte;
+    pthread_t tid;
+    pthread_pool_t pool;
+    slot_t *s;
+
+    while ((opt = getopt(argc, argv, "f:o:t:")) != -1) {
+        switch (opt) {
+            case 'f':
+                if (strcmp(optarg, "text") == 0)
+                    format = FMT_TEXT;
+                else if (strcmp(optarg, "binary") == 0)
+                    format = FMT_BINARY;
+                else
+                    usage(argv[0]);
+                break;
+            case 'o':
+                if (strcmp(optarg, "bitmap") == 0)
+                    output = OUT_BITMAP;
+                else if (strcmp(optarg, "masks") == 0)
+                    output = OUT_MASKS;
+                else if (strcmp(optarg, "none") == 0)
+                    output = OUT_NONE;
+                else
+                    usage(argv[0]);
+                break;
+            case 't':
+                nthread = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (nthread < 0 || nthread > POOL_MAXBSIZE)
+        usage(argv[0]);
+    bitmap = (uint8_t *)malloc(SS_BATCH/8 + 1);
+    for (int i = 0; i < SS_NSLOT; ++i) {
+        slot[i].buf = (uint8_t *)malloc((size_t)SS_BATCH * SK_NCELL);
+        slot[i].units = (uint32_t *)malloc(SS_BATCH * sizeof(uint32_t));
+        if (slot[i].buf == NULL || slot[i].units == NULL || bitmap == NULL) {
+            fprintf(stderr, "malloc error\n");
+            exit(-1);
+        }
+    }
+    sem_init(&filled, 0, 0);
+    sem_init(&empty, 0, SS_NSLOT);
+    if (nthread > 0 && pthread_pool_init(&pool, nthread, nthread) != POOL_SUCCESS) {
+        fprintf(stderr, "pthread_pool_init error\n");
+        exit(-1);
+    }
+    t = now_ns();
+    if (pthread_create(&tid, NULL, reader, argv + optind) != 0) {
+        fprintf(stderr, "pthread_create error\n");
+        exit(-1);
+    }
+    while (1) {
+        sem_wait(&filled);
+        s = &slot[out];
+        if (s->n == 0)
+            break;
+        sudoku_batch(nthread > 0 ? &pool : NULL, s->boards, s->n, s->units);
+        if (s->unmap != NULL)
+            munmap(s->unmap, s->unmap_len);
+        nbyte = 0;
+        for (size_t i = 0; i < s->n; ++i) {
+            acc |= (s->units[i] == SK_ALL) << nbit;
+            nvalid += s->units[i] == SK_ALL;
+            if (++nbit == 8) {
+                bitmap[nbyte++] = acc;
+                acc = 0;
+                nbit = 0;
+            }
+        }
+        if (output == OUT_BITMAP)
+            fwrite(bitmap, 1, nbyte, stdout);
+        else if (output == OUT_MASKS)
+            fwrite(s->units, sizeof(uint32_t), s->n, stdout);
+        nboard += s->n;
+        out = (out + 1) % SS_NSLOT;
+        sem_post(&empty);
+    }
+    if (output == OUT_BITMAP && nbit > 0)
+        fwrite(&acc, 1, 1, stdout);
+    fflush(stdout);
+    pthread_join(tid, NULL);
+    t = now_ns() - t;
+    fprintf(stderr, "boards=%ld valid=%ld malformed=%ld bytes=%ld time=%.3fs boards_per_s=%.0f MB_per_s=%.1f\n",
+            nboard, nvalid, nmalformed, nbytes, t / 1e9, nboard * 1e9 / t, nbytes * 1e3 / t);
+    if (nthread > 0)
+        pthread_pool_shutdown(&pool);
+    for (int i = 0; i < SS_NSLOT; ++i) {
+        free(slot[i].buf);
+        free(slot[i].units);
+    }
+    free(bitmap);
+    sem_destroy(&filled);
+    sem_destroy(&empty);
+    return 0;
+}